@@ -0,0 +1,162 @@
+#ifndef BATCHING_PRODUCER_H_
+#define BATCHING_PRODUCER_H_
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    struct BatchOptions
+    {
+        // the buffer is flushed once it holds that many messages, should not exceed the queue capacity
+        std::size_t maxMessages{ 64 };
+        // ...or by the first Push (or FlushIfDue) that finds its oldest message at least that old, zero means no age limit.
+        // it's an age check, not a timer: the owner's loop should call FlushIfDue by NextDeadline while it doesn't push
+        std::chrono::microseconds maxAge{ 100 };
+        // called with the number of buffered messages that are dropped: by the destructor when the queue has no room
+        // for them, or once the queue is closed. it runs on the owning writer thread, an empty one ignores the drops
+        std::function<void(std::size_t)> onDrop;
+    };
+
+    // opt-in producer handle for MessageQueue (or anything with the same PushGroup/GetStats): a writer thread owns its handle
+    // and pushes into a private buffer without locking, the buffer reaches the queue with one PushGroup (a single lock
+    // acquisition, messages stay adjacent) when it is full, when a Push finds it too old or on explicit Flush.
+    // the producer's FIFO order is kept. the handle itself is not thread-safe, every writer should have its own.
+    // the age is checked on Push and FlushIfDue only, so an idle producer should call FlushIfDue by NextDeadline
+    // (or Flush) to get its last messages delivered in time
+    template<typename Queue>
+    class BatchingProducer final
+    {
+        BatchingProducer(const BatchingProducer&) = delete;
+        BatchingProducer(BatchingProducer&&) = delete;
+        BatchingProducer& operator=(const BatchingProducer&) = delete;
+        BatchingProducer& operator=(BatchingProducer&&) = delete;
+    public:
+        using Message = typename Queue::value_type;
+        using OperationPolicy = typename Queue::OperationPolicy;
+        using Clock = std::chrono::steady_clock;
+
+        BatchingProducer(Queue& queue, BatchOptions options)
+            : m_queue{ queue }
+            , m_options{ options }
+        {
+            if (options.maxMessages == 0 || options.maxMessages > queue.GetStats().capacity)
+                throw std::invalid_argument{ "Invalid BatchOptions: 0 < maxMessages <= queue capacity is expected." };
+
+            m_buffer.reserve(options.maxMessages);
+        }
+
+        // buffered messages are delivered if there is room for them right away, otherwise they are dropped and reported
+        // to onDrop: a destructor shouldn't block forever on a queue nobody drains. Flush<Blocking> beforehand to deliver them for sure
+        ~BatchingProducer()
+        {
+            try
+            {
+                if (Flush<OperationPolicy::NonBlocking>() == Result::Full)
+                    Drop();
+            }
+            catch (...)
+            {
+                // nothing to report to from a destructor
+            }
+        }
+
+        // the message is only buffered, Result::Full (NonBlocking) means the buffer is full and couldn't be flushed,
+        // the message is rejected then. Result::Closed means the queue is closed: buffered messages are dropped
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (m_closed)
+                return Result::Closed;
+
+            // a previous flush has failed, there is no room in the buffer
+            if (m_buffer.size() >= m_options.maxMessages)
+                if (const auto result = Flush<Policy>(); result != Result::Ok)
+                    return result;
+
+            if (m_buffer.empty() && m_options.maxAge != std::chrono::microseconds::zero())
+                m_deadline = Clock::now() + m_options.maxAge;
+            m_buffer.emplace_back(std::forward<Args>(messageCtorArgs)...);
+
+            const bool due = m_buffer.size() >= m_options.maxMessages
+                || (m_options.maxAge != std::chrono::microseconds::zero() && Clock::now() >= m_deadline);
+            if (!due)
+                return Result::Ok;
+
+            // the message is buffered anyway, a full queue only postpones the flush
+            const auto result = Flush<Policy>();
+            return result == Result::Full ? Result::Ok : result;
+        }
+
+        // delivers every buffered message to the queue at once. on Result::Full they stay buffered for the next attempt,
+        // on Result::Closed they are dropped
+        template<OperationPolicy Policy>
+        Result Flush()
+        {
+            if (m_closed)
+                return Result::Closed;
+            if (m_buffer.empty())
+                return Result::Ok;
+
+            // messages are moved out, the buffer keeps its capacity
+            const auto result = m_queue.template PushGroup<Policy>(std::move(m_buffer));
+            if (result == Result::Full)
+                return result;
+
+            m_closed = result == Result::Closed;
+            if (m_closed)
+                Drop();
+            m_buffer.clear();
+            return result;
+        }
+
+        // flushes the buffer if its oldest message has reached maxAge, so the owner's loop can keep the age limit while
+        // it doesn't push. on Result::Full the messages stay buffered, as with Flush
+        template<OperationPolicy Policy>
+        Result FlushIfDue()
+        {
+            if (Clock::now() < NextDeadline())
+                return m_closed ? Result::Closed : Result::Ok;
+
+            return Flush<Policy>();
+        }
+
+        // the moment the buffer is due to be flushed by age, Clock::time_point::max() if nothing is buffered
+        // or there is no age limit. an event loop may use it as its wakeup deadline
+        [[nodiscard]] Clock::time_point NextDeadline() const noexcept
+        {
+            return m_buffer.empty() || m_options.maxAge == std::chrono::microseconds::zero() ? Clock::time_point::max() : m_deadline;
+        }
+
+        // number of buffered messages
+        [[nodiscard]] std::size_t Pending() const noexcept
+        {
+            return m_buffer.size();
+        }
+
+    private:
+        void Drop()
+        {
+            if (m_options.onDrop && !m_buffer.empty())
+                m_options.onDrop(m_buffer.size());
+            m_buffer.clear();
+        }
+
+    private:
+        Queue& m_queue;
+        const BatchOptions m_options;
+        // private to the owning writer, so no locking
+        std::vector<Message> m_buffer;
+        // the moment the oldest buffered message reaches maxAge
+        Clock::time_point m_deadline;
+        // set once the queue reported Closed: nothing will be delivered anymore
+        bool m_closed{ false };
+    };
+}
+
+#endif // BATCHING_PRODUCER_H_
@@ -0,0 +1,226 @@
+#ifndef BROADCAST_QUEUE_H_
+#define BROADCAST_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // what Push does when the slowest subscriber group holds the last free slot
+    enum class LagPolicy {
+        // Push<NonBlocking> returns Result::Full, Push<Blocking> waits for the lagger
+        BlockWriter,
+        // the lagging groups are unsubscribed (their Pop returns Result::Closed) and the slot is reused
+        DropLagger
+    };
+
+    // fan-out flavour of MessageQueue: every subscribed group receives every message pushed after its subscription,
+    // in FIFO order. a message is stored once in a ring and its slot is reclaimed when the slowest group has consumed it.
+    // several readers may share a group, then they compete for its messages as with MessageQueue::Pop
+    template<typename Message>
+    class BroadcastQueue final
+    {
+        BroadcastQueue(const BroadcastQueue&) = delete;
+        BroadcastQueue(BroadcastQueue&&) = delete;
+        BroadcastQueue& operator=(const BroadcastQueue&) = delete;
+        BroadcastQueue& operator=(BroadcastQueue&&) = delete;
+    public:
+        using value_type = Message;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+        using GroupId = std::size_t;
+
+        explicit BroadcastQueue(std::size_t queueSize, LagPolicy lagPolicy = LagPolicy::BlockWriter)
+            : m_ring(queueSize)
+            , m_lagPolicy{ lagPolicy }
+        {
+            if (queueSize == 0)
+                throw std::invalid_argument{ "Invalid BroadcastQueue size: size should be greater than zero." };
+        }
+
+        // the group starts with the next pushed message. messages pushed while there is no group at all are dropped
+        [[nodiscard]] GroupId Subscribe()
+        {
+            std::scoped_lock lk{ m_mtx };
+            m_groups.push_back({ m_tail, true });
+            return m_groups.size() - 1;
+        }
+
+        void Unsubscribe(GroupId group)
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_groups.at(group).active = false;
+                Reclaim();
+            }
+            // the group may have been the lagger
+            m_pushCv.notify_all();
+            m_popCv.notify_all();
+        }
+
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            {
+                std::unique_lock lk{ m_mtx };
+                if (m_tail - m_head == m_ring.size())
+                {
+                    if (m_lagPolicy == LagPolicy::DropLagger)
+                    {
+                        DropLaggers();
+                    }
+                    else if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Full;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
+                        // use predicate to wait on conditions (BroadcastQueue is closed or the slowest group released a slot) and to avoid spurious wakeup
+                        m_pushCv.wait(lk, [this] { return IsClosed() || m_tail - m_head < m_ring.size(); });
+
+                        if (IsClosed())
+                            return Result::Closed;
+                    }
+                }
+
+                m_ring[m_tail % m_ring.size()] = Message(std::forward<Args>(messageCtorArgs)...);
+                ++m_tail;
+                // nobody to deliver to: the slot is free right away
+                Reclaim();
+            }
+            // every group may be waiting for this message; dropped laggers should learn they are closed
+            m_popCv.notify_all();
+
+            return Result::Ok;
+        }
+
+        // returns a copy of the next message of the group, Result::Closed once the group is unsubscribed or dropped
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop(GroupId group)
+        {
+            Message msg{};
+            const auto result = Pop<Policy>(group, [&msg](const Message& next) { msg = next; });
+            return { std::move(msg), result };
+        }
+
+        // passes the next message of the group to handler(const Message&) in place, so no group pays for a copy of the shared slot.
+        // handler runs under the lock: it should be short and must not call back into BroadcastQueue. if it throws,
+        // the message stays the next one of the group
+        template<OperationPolicy Policy, typename Handler>
+        [[nodiscard]] Result Pop(GroupId group, Handler&& handler)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            bool released{ false };
+            {
+                std::unique_lock lk{ m_mtx };
+                auto& state = m_groups.at(group);
+                if (state.active && state.cursor == m_tail)
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Empty;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                        // use predicate to wait on conditions (closed, dropped or there is something to pop) and to avoid spurious wakeup.
+                        // the group is looked up again: m_groups may be reallocated by Subscribe while waiting
+                        m_popCv.wait(lk, [this, group] { return IsClosed() || !m_groups[group].active || m_groups[group].cursor != m_tail; });
+                    }
+                }
+
+                auto& current = m_groups[group];
+                if (IsClosed() || !current.active)
+                    return Result::Closed;
+
+                std::forward<Handler>(handler)(std::as_const(m_ring[current.cursor % m_ring.size()]));
+                // the slot may be released only if this group was the slowest one
+                released = current.cursor++ == m_head;
+                if (released)
+                    Reclaim();
+            }
+            if (released)
+                m_pushCv.notify_one();
+
+            return Result::Ok;
+        }
+
+        // set BroadcastQueue state to Closed and notify all readers/writers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+            }
+            m_popCv.notify_all();
+            m_pushCv.notify_all();
+            return Result::Ok;
+        }
+
+    private:
+        struct Group
+        {
+            // sequence of the next message to deliver
+            std::uint64_t cursor;
+            bool active;
+        };
+
+        // should be called under the lock: the oldest retained message is the one the slowest active group hasn't consumed yet
+        void Reclaim() noexcept
+        {
+            auto head = m_tail;
+            for (const auto& group : m_groups)
+                if (group.active)
+                    head = std::min(head, group.cursor);
+            m_head = head;
+        }
+
+        // should be called under the lock when the ring is full
+        void DropLaggers() noexcept
+        {
+            for (auto& group : m_groups)
+                if (group.active && group.cursor == m_head)
+                    group.active = false;
+            Reclaim();
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_state.load(std::memory_order_acquire) == State::Closed;
+        }
+
+    private:
+        // to protect shared resources (ring, sequences and groups)
+        std::mutex m_mtx;
+        // to wait on condition during blocking pop (there is something new for the group)
+        std::condition_variable m_popCv;
+        // to wait on condition during blocking push (the slowest group released a slot)
+        std::condition_variable m_pushCv;
+        // every message is stored once, slot = sequence % size
+        std::vector<Message> m_ring;
+        // [m_head, m_tail) are sequences of retained messages
+        std::uint64_t m_head{ 0 };
+        std::uint64_t m_tail{ 0 };
+        // GroupId is an index, unsubscribed groups stay inactive
+        std::vector<Group> m_groups;
+        LagPolicy m_lagPolicy{ LagPolicy::BlockWriter };
+
+        enum class State { Running, Closed };
+        std::atomic<State> m_state{ State::Running };
+    };
+}
+
+#endif // BROADCAST_QUEUE_H_
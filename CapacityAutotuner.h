@@ -0,0 +1,109 @@
+#ifndef CAPACITY_AUTOTUNER_H_
+#define CAPACITY_AUTOTUNER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace test_task
+{
+    struct AutotuneOptions
+    {
+        std::size_t minCapacity{ 1 };
+        std::size_t maxCapacity{ 1 };
+        // observation window
+        std::chrono::milliseconds interval{ 100 };
+        // capacity is multiplied by it when a window has seen Full
+        double growFactor{ 2.0 };
+        // capacity is halved when a window's high-water mark stays below this share of it
+        double shrinkThreshold{ 0.25 };
+    };
+
+    // grows and shrinks capacity of a queue (MessageQueue or anything with the same Resize/GetStats/ResetHighWaterMark)
+    // within configured bounds: a window with Full rejections grows it, a window with a low high-water mark shrinks it.
+    // works in its own thread, which is stopped on destruction
+    template<typename Queue>
+    class CapacityAutotuner final
+    {
+        CapacityAutotuner(const CapacityAutotuner&) = delete;
+        CapacityAutotuner(CapacityAutotuner&&) = delete;
+        CapacityAutotuner& operator=(const CapacityAutotuner&) = delete;
+        CapacityAutotuner& operator=(CapacityAutotuner&&) = delete;
+    public:
+        CapacityAutotuner(Queue& queue, AutotuneOptions options)
+            : m_queue{ queue }
+            , m_options{ options }
+            , m_lastFullRejections{ queue.GetStats().fullRejections }
+        {
+            if (options.minCapacity == 0 || options.minCapacity > options.maxCapacity)
+                throw std::invalid_argument{ "Invalid AutotuneOptions: 0 < minCapacity <= maxCapacity is expected." };
+            if (options.growFactor <= 1.0 || options.shrinkThreshold < 0.0 || options.shrinkThreshold >= 1.0)
+                throw std::invalid_argument{ "Invalid AutotuneOptions: growFactor > 1 and 0 <= shrinkThreshold < 1 are expected." };
+
+            m_queue.ResetHighWaterMark();
+            m_thread = std::thread{ [this] { Run(); } };
+        }
+
+        ~CapacityAutotuner()
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_stop = true;
+            }
+            m_stopCv.notify_one();
+            m_thread.join();
+        }
+
+    private:
+        // evaluates the window since the previous step and returns the capacity chosen for the next one
+        std::size_t Step()
+        {
+            const auto highWaterMark = m_queue.ResetHighWaterMark();
+            const auto stats = m_queue.GetStats();
+            const auto fullRejections = stats.fullRejections - m_lastFullRejections;
+            m_lastFullRejections = stats.fullRejections;
+
+            auto capacity = stats.capacity;
+            // a small capacity times a small factor may round back down to itself, grow by at least one slot
+            if (fullRejections > 0)
+                capacity = std::max(capacity + 1, static_cast<std::size_t>(static_cast<double>(capacity) * m_options.growFactor));
+            else if (static_cast<double>(highWaterMark) < static_cast<double>(capacity) * m_options.shrinkThreshold)
+                // keep twice the observed peak to avoid oscillation
+                capacity = std::max(capacity / 2, highWaterMark * 2);
+
+            capacity = std::clamp(capacity, m_options.minCapacity, m_options.maxCapacity);
+            if (capacity != stats.capacity)
+                m_queue.Resize(capacity);
+
+            return capacity;
+        }
+
+        void Run()
+        {
+            std::unique_lock lk{ m_mtx };
+            while (!m_stopCv.wait_for(lk, m_options.interval, [this] { return m_stop; }))
+            {
+                lk.unlock();
+                Step();
+                lk.lock();
+            }
+        }
+
+    private:
+        Queue& m_queue;
+        AutotuneOptions m_options;
+        std::uint64_t m_lastFullRejections{ 0 };
+
+        // to interrupt the interval waiting on destruction
+        std::mutex m_mtx;
+        std::condition_variable m_stopCv;
+        bool m_stop{ false };
+        std::thread m_thread;
+    };
+}
+
+#endif // CAPACITY_AUTOTUNER_H_
@@ -0,0 +1,205 @@
+#ifndef CONFLATING_MESSAGE_QUEUE_H_
+#define CONFLATING_MESSAGE_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // MessageQueue flavour for "latest value wins" feeds (e.g. market data): a pushed message whose key is already queued
+    // replaces the queued one in place, keeping its original FIFO position, so readers always get the freshest value
+    // and the depth is bounded by the number of distinct keys. KeyOf extracts a hashable key from a message
+    template<typename Message, typename KeyOf>
+    class ConflatingMessageQueue final
+    {
+        ConflatingMessageQueue(const ConflatingMessageQueue&) = delete;
+        ConflatingMessageQueue(ConflatingMessageQueue&&) = delete;
+        ConflatingMessageQueue& operator=(const ConflatingMessageQueue&) = delete;
+        ConflatingMessageQueue& operator=(ConflatingMessageQueue&&) = delete;
+    public:
+        using value_type = Message;
+        using key_type = std::decay_t<std::invoke_result_t<const KeyOf&, const Message&>>;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+
+        explicit ConflatingMessageQueue(std::size_t queueSize, KeyOf keyOf = {})
+            : m_keyOf{ std::move(keyOf) }
+            , m_queueSize{ queueSize }
+        {
+            if (queueSize == 0)
+                throw std::invalid_argument{ "Invalid ConflatingMessageQueue size: size should be greater than zero." };
+
+            m_index.reserve(queueSize);
+        }
+
+        // replacing a queued message never fails nor waits, only a message with a new key may find the queue full
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            // build the message and its key outside of the lock
+            Message msg(std::forward<Args>(messageCtorArgs)...);
+            auto key = m_keyOf(std::as_const(msg));
+            {
+                std::unique_lock lk{ m_mtx };
+                while (true)
+                {
+                    if (const auto indexIt = m_index.find(key); indexIt != m_index.end())
+                    {
+                        // O(1) in place replacement, the message keeps its position
+                        *indexIt->second = std::move(msg);
+                        ++m_conflated;
+                        return Result::Ok;
+                    }
+
+                    if (m_queue.size() < m_queueSize)
+                        break;
+
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Full;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
+                        // the same key may be pushed by another writer in the meantime, so the index is checked again after waiting
+                        m_pushCv.wait(lk);
+
+                        if (IsClosed())
+                            return Result::Closed;
+                    }
+                }
+                // add a message to the end... (FIFO) [1/2]
+                m_queue.push_back(std::move(msg));
+                m_index.emplace(std::move(key), std::prev(m_queue.end()));
+            }
+            // after adding a message to the queue (there is something to pop) it's time to wake up a reader(if any)
+            m_popCv.notify_one();
+
+            return Result::Ok;
+        }
+
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop()
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            Message msg;
+            {
+                std::unique_lock lk{ m_mtx };
+                if (m_queue.empty())
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return { {}, Result::Empty };
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                        // use predicate to wait on conditions (MessageQueue is closed or there is something to pop) and to avoid spurious wakeup
+                        m_popCv.wait(lk, [this] { return IsClosed() || !m_queue.empty(); });
+
+                        if (IsClosed())
+                            return { {}, Result::Closed };
+                    }
+                }
+                // ...while pop from the beginning (FIFO) [2/2]
+                Erase(m_queue.begin(), msg);
+            }
+            // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
+            m_pushCv.notify_one();
+
+            return { std::move(msg), Result::Ok };
+        }
+
+        // Returns the first message that satisfies provided Predicate
+        template<typename Predicate>
+        [[nodiscard]] std::pair<Message, Result> Get(Predicate&& predicate)
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            Message msg;
+            {
+                std::unique_lock lk{ m_mtx };
+                if (m_queue.empty())
+                    return { {}, Result::Empty };
+
+                const auto msgIt = std::find_if(m_queue.begin(), m_queue.end(), std::forward<Predicate>(predicate));
+                if (msgIt == m_queue.end())
+                    return { {}, Result::NotFound };
+
+                Erase(msgIt, msg);
+            }
+            // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
+            m_pushCv.notify_one();
+
+            return { std::move(msg), Result::Ok };
+        }
+
+        // set ConflatingMessageQueue state to Closed and notify all readers/writers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+            }
+            m_popCv.notify_all();
+            m_pushCv.notify_all();
+            return Result::Ok;
+        }
+
+        // number of pushes that replaced a queued message
+        [[nodiscard]] std::uint64_t ConflatedCount()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return m_conflated;
+        }
+
+    private:
+        using Queue = std::list<Message>;
+
+        // should be called under the lock
+        void Erase(typename Queue::iterator msgIt, Message& msg)
+        {
+            m_index.erase(m_keyOf(std::as_const(*msgIt)));
+            msg = std::move(*msgIt);
+            m_queue.erase(msgIt);
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_state.load(std::memory_order_acquire) == State::Closed;
+        }
+
+    private:
+        KeyOf m_keyOf;
+        // to protect shared resources (messages queue and its index)
+        std::mutex m_mtx;
+        std::condition_variable m_popCv;
+        std::condition_variable m_pushCv;
+        // list iterators are stable, so the index may point right into the queue
+        Queue m_queue;
+        std::unordered_map<key_type, typename Queue::iterator> m_index;
+        std::size_t m_queueSize{ 1 };
+        std::uint64_t m_conflated{ 0 };
+
+        enum class State { Running, Closed };
+        std::atomic<State> m_state{ State::Running };
+    };
+}
+
+#endif // CONFLATING_MESSAGE_QUEUE_H_
@@ -0,0 +1,199 @@
+#ifndef FIXED_MESSAGE_QUEUE_H_
+#define FIXED_MESSAGE_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // MessageQueue flavour with the capacity known at compile time: messages live in an inline ring of N slots, so the queue
+    // never touches the heap and may be embedded as a member, while the compiler sees constant bounds.
+    // index wrapping is a mask when N is a power of two and a compare-and-subtract otherwise (never a modulo)
+    template<typename Message, std::size_t N>
+    class FixedMessageQueue final
+    {
+        static_assert(N > 0, "FixedMessageQueue: N should be greater than zero.");
+
+        FixedMessageQueue(const FixedMessageQueue&) = delete;
+        FixedMessageQueue(FixedMessageQueue&&) = delete;
+        FixedMessageQueue& operator=(const FixedMessageQueue&) = delete;
+        FixedMessageQueue& operator=(FixedMessageQueue&&) = delete;
+    public:
+        using value_type = Message;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+
+        FixedMessageQueue() = default;
+
+        ~FixedMessageQueue()
+        {
+            for (std::size_t i = 0; i < m_size; ++i)
+                std::destroy_at(Slot(m_head + i));
+        }
+
+        [[nodiscard]] static constexpr std::size_t Capacity() noexcept
+        {
+            return N;
+        }
+
+        // clients may provide either Message itself or arguments enough to construct Message instance
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            {
+                std::unique_lock lk{ m_mtx };
+                if (m_size == N)
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Full;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
+                        // use predicate to wait on conditions (FixedMessageQueue is closed or there is some free space to push into) and to avoid spurious wakeup
+                        m_pushCv.wait(lk, [this] { return IsClosed() || m_size != N; });
+
+                        if (IsClosed())
+                            return Result::Closed;
+                    }
+                }
+                // add a message to the end... (FIFO) [1/2]
+                ::new (static_cast<void*>(Slot(m_head + m_size))) Message(std::forward<Args>(messageCtorArgs)...);
+                ++m_size;
+            }
+            // after adding a message to the queue (there is something to pop) it's time to wake up a reader(if any)
+            m_popCv.notify_one();
+
+            return Result::Ok;
+        }
+
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop()
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            Message msg;
+            {
+                std::unique_lock lk{ m_mtx };
+                if (m_size == 0)
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return { {}, Result::Empty };
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                        // use predicate to wait on conditions (FixedMessageQueue is closed or there is something to pop) and to avoid spurious wakeup
+                        m_popCv.wait(lk, [this] { return IsClosed() || m_size != 0; });
+
+                        if (IsClosed())
+                            return { {}, Result::Closed };
+                    }
+                }
+                // ...while pop from the beginning (FIFO) [2/2]
+                auto* head = Slot(m_head);
+                msg = std::move(*head);
+                std::destroy_at(head);
+                m_head = Wrap(m_head + 1);
+                --m_size;
+            }
+            // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
+            m_pushCv.notify_one();
+
+            return { std::move(msg), Result::Ok };
+        }
+
+        // Returns the first message that satisfies provided Predicate, the following ones are shifted to close the gap
+        template<typename Predicate>
+        [[nodiscard]] std::pair<Message, Result> Get(Predicate&& predicate)
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            Message msg;
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (m_size == 0)
+                    return { {}, Result::Empty };
+
+                std::size_t found{ 0 };
+                while (found < m_size && !predicate(std::as_const(*Slot(m_head + found))))
+                    ++found;
+                if (found == m_size)
+                    return { {}, Result::NotFound };
+
+                msg = std::move(*Slot(m_head + found));
+                for (auto i = found + 1; i < m_size; ++i)
+                    *Slot(m_head + i - 1) = std::move(*Slot(m_head + i));
+                std::destroy_at(Slot(m_head + m_size - 1));
+                --m_size;
+            }
+            // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
+            m_pushCv.notify_one();
+
+            return { std::move(msg), Result::Ok };
+        }
+
+        // set FixedMessageQueue state to Closed and notify all readers/writers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+            }
+            m_popCv.notify_all();
+            m_pushCv.notify_all();
+            return Result::Ok;
+        }
+
+    private:
+        static constexpr bool IsPowerOfTwo{ (N & (N - 1)) == 0 };
+
+        // index should be less than 2 * N: it is the head index (< N) plus an offset (< N)
+        static constexpr std::size_t Wrap(std::size_t index) noexcept
+        {
+            if constexpr (IsPowerOfTwo)
+                return index & (N - 1);
+            else
+                return index >= N ? index - N : index;
+        }
+
+        Message* Slot(std::size_t index) noexcept
+        {
+            return std::launder(reinterpret_cast<Message*>(m_storage + Wrap(index) * sizeof(Message)));
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_state.load(std::memory_order_acquire) == State::Closed;
+        }
+
+    private:
+        // to protect shared resources (ring and its indexes)
+        std::mutex m_mtx;
+        // to wait on condition during blocking pop (not empty condition, there is something to pop)
+        std::condition_variable m_popCv;
+        // to wait on condition during blocking push (not full condition, there is some free space to push into)
+        std::condition_variable m_pushCv;
+        // messages occupy m_size slots starting from m_head (wrapping), slots are constructed on push and destroyed on pop
+        alignas(Message) unsigned char m_storage[N * sizeof(Message)];
+        std::size_t m_head{ 0 };
+        std::size_t m_size{ 0 };
+
+        enum class State { Running, Closed };
+        std::atomic<State> m_state{ State::Running };
+    };
+}
+
+#endif // FIXED_MESSAGE_QUEUE_H_
@@ -0,0 +1,285 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace test_task
+{
+    struct JournalOptions
+    {
+        // how long a group commit leader waits for more writers to join the batch before write+fdatasync.
+        // zero means flush immediately: concurrent writers are still batched while the previous fdatasync is in progress
+        std::chrono::microseconds syncInterval{ 0 };
+        // the log is truncated once the queue drains while the file is larger than this
+        std::size_t compactThreshold{ 64 * 1024 * 1024 };
+    };
+
+    // write-ahead log of queue mutations: pushed messages and removals (by position in the queue at removal time).
+    // records are buffered by the owner under its own lock (so the log order matches the queue order),
+    // while durability is awaited outside of it: the first waiting thread becomes a group commit leader
+    // and writes+syncs everything buffered so far on behalf of all waiters
+    class Journal final
+    {
+        Journal(const Journal&) = delete;
+        Journal(Journal&&) = delete;
+        Journal& operator=(const Journal&) = delete;
+        Journal& operator=(Journal&&) = delete;
+    public:
+        enum class RecordType : std::uint8_t {
+            Push = 1,
+            Remove = 2
+        };
+
+        using Ticket = std::uint64_t;
+
+        Journal(std::string path, JournalOptions options)
+            : m_path{ std::move(path) }
+            , m_options{ options }
+            , m_fd{ ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR) }
+        {
+            if (m_fd < 0)
+                throw std::system_error{ errno, std::system_category(), "Journal: open failed" };
+
+            struct stat st {};
+            if (::fstat(m_fd, &st) == 0)
+                m_fileSize = static_cast<std::size_t>(st.st_size);
+        }
+
+        ~Journal()
+        {
+            // best effort: removals are not awaited by anyone, so they may still be buffered
+            try
+            {
+                WaitDurable(m_appended);
+            }
+            catch (...)
+            {
+            }
+            ::close(m_fd);
+        }
+
+        // calls onRecord(type, payload) for every complete record of the log at path (if any).
+        // a torn or corrupted tail (e.g. after a crash in the middle of a write) ends the replay
+        template<typename OnRecord>
+        static void Replay(const std::string& path, OnRecord&& onRecord)
+        {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file)
+            {
+                if (errno == ENOENT)
+                    return;
+                throw std::system_error{ errno, std::system_category(), "Journal: replay failed" };
+            }
+
+            std::string payload;
+            RecordHeader header{};
+            while (std::fread(&header, sizeof(header), 1, file) == 1)
+            {
+                payload.resize(header.size);
+                if (std::fread(payload.data(), 1, payload.size(), file) != payload.size() || Checksum(header, payload) != header.checksum)
+                    break;
+
+                onRecord(static_cast<RecordType>(header.type), std::string_view{ payload });
+            }
+            std::fclose(file);
+        }
+
+        // atomically replaces the log at path with the provided messages (already serialized)
+        static void Rewrite(const std::string& path, const std::deque<std::string>& messages)
+        {
+            const auto tmpPath = path + ".tmp";
+            const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+                throw std::system_error{ errno, std::system_category(), "Journal: rewrite failed" };
+
+            std::string buffer;
+            for (const auto& msg : messages)
+                Encode(buffer, RecordType::Push, msg);
+
+            const bool written = WriteAll(fd, buffer) && ::fdatasync(fd) == 0;
+            const int error = errno;
+            ::close(fd);
+            if (!written || ::rename(tmpPath.c_str(), path.c_str()) != 0)
+                throw std::system_error{ written ? errno : error, std::system_category(), "Journal: rewrite failed" };
+
+            SyncDirectory(path);
+        }
+
+        // should be called under the owner's lock (defines the record order), doesn't touch the file
+        Ticket Append(RecordType type, std::string_view payload)
+        {
+            std::scoped_lock lk{ m_mtx };
+            Encode(m_pending, type, payload);
+            return ++m_appended;
+        }
+
+        // should be called under the owner's lock when the queue is empty: every logged push has a matching removal by now,
+        // so a large log can be dropped entirely
+        void CompactIfEmpty()
+        {
+            std::scoped_lock lk{ m_mtx };
+            if (m_flushing || m_fileSize + m_pending.size() < m_options.compactThreshold)
+                return;
+
+            if (::ftruncate(m_fd, 0) != 0 || ::fdatasync(m_fd) != 0)
+                return;
+
+            m_pending.clear();
+            m_fileSize = 0;
+            m_durable = m_appended;
+            m_durableCv.notify_all();
+        }
+
+        // blocks until the record with the ticket (and every record before it) is on disk
+        void WaitDurable(Ticket ticket)
+        {
+            std::unique_lock lk{ m_mtx };
+            while (m_durable < ticket)
+            {
+                if (m_error != 0)
+                    throw std::system_error{ m_error, std::system_category(), "Journal: write failed" };
+
+                if (m_flushing)
+                {
+                    // somebody else is the leader, its batch or the next one will cover this ticket
+                    m_durableCv.wait(lk);
+                    continue;
+                }
+
+                m_flushing = true;
+                if (m_options.syncInterval.count() > 0)
+                {
+                    // let more writers join the batch
+                    lk.unlock();
+                    std::this_thread::sleep_for(m_options.syncInterval);
+                    lk.lock();
+                }
+
+                std::string batch;
+                batch.swap(m_pending);
+                const auto batchEnd = m_appended;
+
+                lk.unlock();
+                const bool written = WriteAll(m_fd, batch) && ::fdatasync(m_fd) == 0;
+                const int error = errno;
+                lk.lock();
+
+                m_flushing = false;
+                if (written)
+                {
+                    m_fileSize += batch.size();
+                    m_durable = batchEnd;
+                }
+                else
+                {
+                    m_error = error;
+                }
+                m_durableCv.notify_all();
+            }
+        }
+
+    private:
+        struct RecordHeader
+        {
+            std::uint32_t size;
+            std::uint32_t checksum;
+            // 32-bit to keep the header free of padding bytes, it is written as is
+            std::uint32_t type;
+        };
+
+        // FNV-1a over the header fields and the payload, enough to detect a torn tail
+        static std::uint32_t Checksum(const RecordHeader& header, std::string_view payload) noexcept
+        {
+            std::uint32_t hash{ 2166136261u };
+            const auto mix = [&hash](unsigned char byte) { hash = (hash ^ byte) * 16777619u; };
+            mix(static_cast<unsigned char>(header.type));
+            for (std::size_t i = 0; i < sizeof(header.size); ++i)
+                mix(static_cast<unsigned char>(header.size >> (i * 8)));
+            for (const auto byte : payload)
+                mix(static_cast<unsigned char>(byte));
+            return hash;
+        }
+
+        static void Encode(std::string& buffer, RecordType type, std::string_view payload)
+        {
+            if (payload.size() > UINT32_MAX)
+                throw std::length_error{ "Journal: record is too large." };
+
+            RecordHeader header{};
+            header.size = static_cast<std::uint32_t>(payload.size());
+            header.type = static_cast<std::uint32_t>(type);
+            header.checksum = Checksum(header, payload);
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            buffer.append(payload);
+        }
+
+        static bool WriteAll(int fd, std::string_view data) noexcept
+        {
+            while (!data.empty())
+            {
+                const auto written = ::write(fd, data.data(), data.size());
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                data.remove_prefix(static_cast<std::size_t>(written));
+            }
+            return true;
+        }
+
+        static void SyncDirectory(const std::string& path) noexcept
+        {
+            const auto slash = path.find_last_of('/');
+            const auto directory = slash == std::string::npos ? std::string{ "." } : path.substr(0, slash == 0 ? 1 : slash);
+            const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0)
+                return;
+            ::fsync(fd);
+            ::close(fd);
+        }
+
+    private:
+        std::string m_path;
+        JournalOptions m_options;
+        int m_fd{ -1 };
+
+        // protects everything below
+        std::mutex m_mtx;
+        // signaled when a group commit is finished
+        std::condition_variable m_durableCv;
+        // records appended since the last group commit
+        std::string m_pending;
+        Ticket m_appended{ 0 };
+        Ticket m_durable{ 0 };
+        // there is a leader writing a batch right now
+        bool m_flushing{ false };
+        // sticky: once a write fails, durability can't be promised anymore
+        int m_error{ 0 };
+        std::size_t m_fileSize{ 0 };
+    };
+}
+
+#endif // __linux__
+
+#endif // JOURNAL_H_
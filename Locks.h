@@ -0,0 +1,215 @@
+#ifndef LOCKS_H_
+#define LOCKS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// lock policies for MessageQueue (any BasicLockable fits, std::mutex is the default one).
+// critical sections of Push/Pop are a few instructions long, so spinning may beat sleeping in the kernel.
+// every spinning lock gives the core away after a while, so a preempted holder can't stall waiters for a whole time slice
+namespace test_task
+{
+    namespace detail
+    {
+        // exponential backoff: pause instructions while the wait is short, yielding once it gets long
+        class Backoff final
+        {
+        public:
+            void Pause() noexcept
+            {
+                if (m_spins >= MaxSpins)
+                {
+                    std::this_thread::yield();
+                    return;
+                }
+
+                for (std::uint32_t i = 0; i < m_spins; ++i)
+                    CpuRelax();
+                m_spins *= 2;
+            }
+
+        private:
+            static void CpuRelax() noexcept
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#elif defined(__aarch64__)
+                asm volatile("yield");
+#endif
+            }
+
+        private:
+            static constexpr std::uint32_t MaxSpins{ 64 };
+            std::uint32_t m_spins{ 1 };
+        };
+    }
+
+    // test-and-test-and-set spinlock: waiters spin on a plain load (the cache line stays shared),
+    // the atomic exchange is tried only once the lock looks free
+    class SpinLock final
+    {
+        SpinLock(const SpinLock&) = delete;
+        SpinLock(SpinLock&&) = delete;
+        SpinLock& operator=(const SpinLock&) = delete;
+        SpinLock& operator=(SpinLock&&) = delete;
+    public:
+        SpinLock() = default;
+
+        void lock() noexcept
+        {
+            detail::Backoff backoff;
+            while (m_locked.exchange(true, std::memory_order_acquire))
+                while (m_locked.load(std::memory_order_relaxed))
+                    backoff.Pause();
+        }
+
+        bool try_lock() noexcept
+        {
+            return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock() noexcept
+        {
+            m_locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<bool> m_locked{ false };
+    };
+
+    // FIFO-fair spinlock: a waiter takes a ticket and waits until it is served.
+    // fairness hurts once threads outnumber cores: the lock is handed to the next waiter even if it is preempted
+    class TicketLock final
+    {
+        TicketLock(const TicketLock&) = delete;
+        TicketLock(TicketLock&&) = delete;
+        TicketLock& operator=(const TicketLock&) = delete;
+        TicketLock& operator=(TicketLock&&) = delete;
+    public:
+        TicketLock() = default;
+
+        void lock() noexcept
+        {
+            const auto ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+            detail::Backoff backoff;
+            while (m_serving.load(std::memory_order_acquire) != ticket)
+                backoff.Pause();
+        }
+
+        void unlock() noexcept
+        {
+            // only the holder writes it
+            m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        // on separate cache lines: taking a ticket shouldn't disturb waiters watching the served one
+        alignas(64) std::atomic<std::uint32_t> m_next{ 0 };
+        alignas(64) std::atomic<std::uint32_t> m_serving{ 0 };
+    };
+
+    // MCS queue lock: FIFO-fair (with the same oversubscription caveat as TicketLock), and every waiter spins on its own node,
+    // so a release touches a single waiter's cache line.
+    // nodes come from a per-thread pool, a thread may hold several McsLocks at once and release them in any order
+    class McsLock final
+    {
+        McsLock(const McsLock&) = delete;
+        McsLock(McsLock&&) = delete;
+        McsLock& operator=(const McsLock&) = delete;
+        McsLock& operator=(McsLock&&) = delete;
+    public:
+        McsLock() = default;
+
+        void lock()
+        {
+            auto* node = AcquireNode();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->locked.store(true, std::memory_order_relaxed);
+
+            if (auto* predecessor = m_tail.exchange(node, std::memory_order_acq_rel))
+            {
+                predecessor->next.store(node, std::memory_order_release);
+                detail::Backoff backoff;
+                while (node->locked.load(std::memory_order_acquire))
+                    backoff.Pause();
+            }
+            // protected by the lock itself, tells unlock() which node is the holder's one
+            m_owner = node;
+        }
+
+        void unlock() noexcept
+        {
+            auto* node = m_owner;
+            auto* successor = node->next.load(std::memory_order_acquire);
+            if (!successor)
+            {
+                // no waiter: the lock becomes free unless somebody is enqueueing right now
+                auto* expected = node;
+                if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel))
+                {
+                    ReleaseNode(node);
+                    return;
+                }
+                // the newcomer has swapped the tail but hasn't linked itself yet
+                detail::Backoff backoff;
+                while (!(successor = node->next.load(std::memory_order_acquire)))
+                    backoff.Pause();
+            }
+            successor->locked.store(false, std::memory_order_release);
+            // the successor never touches the node again
+            ReleaseNode(node);
+        }
+
+    private:
+        struct alignas(64) Node
+        {
+            std::atomic<Node*> next{ nullptr };
+            std::atomic<bool> locked{ false };
+        };
+
+        struct NodePool
+        {
+            std::vector<std::unique_ptr<Node>> nodes;
+            std::vector<Node*> free;
+        };
+
+        static NodePool& Pool()
+        {
+            thread_local NodePool pool;
+            return pool;
+        }
+
+        static Node* AcquireNode()
+        {
+            auto& pool = Pool();
+            if (pool.free.empty())
+            {
+                pool.nodes.push_back(std::make_unique<Node>());
+                // reserved upfront, so releasing never allocates
+                pool.free.reserve(pool.nodes.size());
+                return pool.nodes.back().get();
+            }
+            auto* node = pool.free.back();
+            pool.free.pop_back();
+            return node;
+        }
+
+        static void ReleaseNode(Node* node) noexcept
+        {
+            Pool().free.push_back(node);
+        }
+
+    private:
+        std::atomic<Node*> m_tail{ nullptr };
+        Node* m_owner{ nullptr };
+    };
+}
+
+#endif // LOCKS_H_
@@ -0,0 +1,21 @@
+#ifndef MESSAGE_CODEC_H_
+#define MESSAGE_CODEC_H_
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace test_task
+{
+    // user-supplied conversion of a Message to/from bytes, used wherever messages leave process memory (e.g. spill to disk)
+    template<typename Message>
+    struct MessageCodec
+    {
+        // should append serialized message to the provided buffer
+        std::function<void(const Message&, std::string&)> serialize;
+        // should rebuild a message from exactly the bytes produced by serialize
+        std::function<Message(std::string_view)> deserialize;
+    };
+}
+
+#endif // MESSAGE_CODEC_H_
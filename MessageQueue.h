@@ -3,11 +3,27 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iterator>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "Journal.h"
+#include "MessageCodec.h"
+#include "ReadinessFd.h"
+#include "SpillStore.h"
+#include "TraceRecorder.h"
 
 namespace test_task
 {
@@ -19,7 +35,20 @@ namespace test_task
         Closed
     };
 
-    template<typename Message>
+    // what Push does when MessageQueue is full
+    enum class OverflowPolicy {
+        // Push<NonBlocking> returns Result::Full, Push<Blocking> waits
+        Reject,
+        // the oldest (head) message is evicted to make room, its list node is reused for the new one
+        DropOldest,
+        // the new message is dropped (Push still returns Result::Ok)
+        DropNewest,
+        // the newest (tail) message is overwritten in place by the new one
+        Overwrite
+    };
+
+    // Lock protects the queue state, any BasicLockable fits (see Locks.h for spinning alternatives to std::mutex)
+    template<typename Message, OverflowPolicy Overflow = OverflowPolicy::Reject, typename Lock = std::mutex>
     class MessageQueue final
     {
         MessageQueue(const MessageQueue&) = delete;
@@ -28,12 +57,39 @@ namespace test_task
         MessageQueue& operator=(MessageQueue&&) = delete;
     public:
         using value_type = Message;
+        using Clock = std::chrono::steady_clock;
 
         enum class OperationPolicy {
             Blocking,
             NonBlocking
         };
 
+        enum class Watermark {
+            High,
+            Low
+        };
+        using EvictionHandler = std::function<void(Message&&)>;
+
+        // called with the crossed watermark and the depth at the crossing time
+        using WatermarkCallback = std::function<void(Watermark, std::size_t)>;
+
+        struct Stats
+        {
+            // number of messages kept in memory
+            std::size_t size;
+            std::size_t capacity;
+            // the largest size since construction or the last ResetHighWaterMark()
+            std::size_t highWaterMark;
+            // pushes that found the queue full (rejected NonBlocking ones and waiting Blocking ones) since construction
+            std::uint64_t fullRejections;
+            // messages dropped by the overflow policy since construction
+            std::uint64_t evicted;
+            // messages dropped because their deadline has passed since construction
+            std::uint64_t expired;
+            // delayed messages that are not visible yet
+            std::size_t delayed;
+        };
+
         explicit MessageQueue(std::size_t queueSize)
             : m_queueSize{ queueSize }
         {
@@ -44,128 +100,1435 @@ namespace test_task
         // clients may provide either Message itself or arguments enough to construct Message instance
         template<OperationPolicy Policy, typename... Args>
         [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            const auto defaultTtl = Clock::duration{ m_defaultTtl.load(std::memory_order_relaxed) };
+            const auto deadline = defaultTtl == Clock::duration::zero() ? NoDeadline : Clock::now() + defaultTtl;
+            return PushUntil<Policy>(deadline, std::forward<Args>(messageCtorArgs)...);
+        }
+
+        // once the deadline passes, the message is silently dropped instead of being delivered (see Stats::expired)
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result PushUntil(Clock::time_point deadline, Args&&... messageCtorArgs)
+        {
+            constexpr auto operation = Policy == OperationPolicy::Blocking ? TraceOperation::PushBlocking : TraceOperation::PushNonBlocking;
+            const auto result = Traced(operation, [&] { return PushImpl<Policy>(deadline, std::forward<Args>(messageCtorArgs)...); });
+            DeliverWatermarkEvents();
+            return result;
+        }
+
+        template<OperationPolicy Policy, typename Rep, typename Period, typename... Args>
+        [[nodiscard]] Result PushFor(std::chrono::duration<Rep, Period> ttl, Args&&... messageCtorArgs)
+        {
+            return PushUntil<Policy>(Clock::now() + std::chrono::duration_cast<Clock::duration>(ttl), std::forward<Args>(messageCtorArgs)...);
+        }
+
+        // the message stays invisible to readers until visibleAt, then it is appended to the queue (once there is free space)
+        // in visibleAt order. delayed messages don't occupy queue slots, so it never waits nor reports Result::Full.
+        // a blocked Pop wakes up exactly when the earliest delayed message becomes visible, and the readable descriptor
+        // (if enabled) becomes readable at that moment too (a timer), so the following Pop makes it visible. delayed messages are kept in memory only,
+        // so they are rejected (std::logic_error) while the journal is enabled: a durable Push would be silently lost otherwise
+        template<typename... Args>
+        [[nodiscard]] Result PushDelayed(Clock::time_point visibleAt, Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (IsJournalEnabled())
+                    throw std::logic_error{ "MessageQueue delayed messages are not supported while the journal is enabled." };
+
+                m_delayed.push_back(Delayed{ visibleAt, m_delayedSeq++, Message(std::forward<Args>(messageCtorArgs)...) });
+                std::push_heap(m_delayed.begin(), m_delayed.end(), LaterVisible{});
+                // a blocked reader (and the readable descriptor timer) should recalculate its waiting deadline
+                if (m_delayed.front().seq == m_delayedSeq - 1)
+                {
+                    UpdateReadiness();
+                    SignalFirst(m_popLine);
+                }
+            }
+
+            return Result::Ok;
+        }
+
+        // enqueues every message of the group adjacently (no other writer interleaves) in one critical section, or none of them:
+        // NonBlocking returns Result::Full unless there is room for the whole group, Blocking waits for it.
+        // the overflow policy doesn't apply, a group is never dropped partially. a group larger than the capacity is
+        // reported as Full by both policies (unless spill is enabled). messages are moved out of an rvalue range,
+        // and moved back into it if the group is rejected
+        template<OperationPolicy Policy, typename Range>
+        [[nodiscard]] Result PushGroup(Range&& group)
+        {
+            const auto result = PushGroupImpl<Policy>(std::forward<Range>(group));
+            DeliverWatermarkEvents();
+            return result;
+        }
+
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop()
+        {
+            constexpr auto operation = Policy == OperationPolicy::Blocking ? TraceOperation::PopBlocking : TraceOperation::PopNonBlocking;
+            auto outcome = Traced(operation, [this] { return PopImpl<Policy>(); });
+            DeliverWatermarkEvents();
+            return outcome;
+        }
+
+        // Returns the first message that satisfies provided Predicate.
+        // only messages kept in memory are inspected, spilled ones become visible once they are fed back
+        template<typename Predicate>
+        [[nodiscard]] std::pair<Message, Result> Get(Predicate&& predicate)
+        {
+            auto outcome = Traced(TraceOperation::Get, [&] { return GetImpl(std::forward<Predicate>(predicate)); });
+            DeliverWatermarkEvents();
+            return outcome;
+        }
+
+        // extracts every message that satisfies provided Predicate in a single pass under one lock acquisition,
+        // writes them to out in FIFO order and returns their number. like Get, it sees only messages kept in memory
+        template<typename Predicate, typename OutputIt>
+        std::size_t GetAll(Predicate&& predicate, OutputIt out)
+        {
+            return ExtractIf(predicate, [&out](Message&& msg) { *out++ = std::move(msg); });
+        }
+
+        // drops every message that satisfies provided Predicate in a single pass, returns their number
+        template<typename Predicate>
+        std::size_t RemoveIf(Predicate&& predicate)
+        {
+            return ExtractIf(predicate, [](Message&&) {});
+        }
+
+        // returns a copy of the head message without removing it (what Pop would return now)
+        [[nodiscard]] std::pair<Message, Result> Peek()
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            std::pair<Message, Result> outcome{ {}, Result::Empty };
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (!m_delayed.empty())
+                    PromoteDelayed(Clock::now());
+
+                const auto now = m_ttlUsed ? Clock::now() : Clock::time_point{};
+                const auto msgIt = std::find_if(m_queue.begin(), m_queue.end(), [this, now](const Entry& entry) { return !m_ttlUsed || !IsExpired(entry, now); });
+                if (msgIt != m_queue.end())
+                    outcome = { msgIt->message, Result::Ok };
+            }
+            DeliverWatermarkEvents();
+            return outcome;
+        }
+
+        // calls visitor(const Message&) for every queued message in FIFO order without removing them, returns their number.
+        // the lock is held only to copy the messages (copy-on-read snapshot), the visitor runs without it,
+        // so a slow inspector never stalls writers and readers. like Get, it sees only messages kept in memory
+        template<typename Visitor>
+        std::size_t VisitSnapshot(Visitor&& visitor)
+        {
+            std::vector<Message> snapshot;
+            {
+                std::scoped_lock lk{ m_mtx };
+                const auto now = m_ttlUsed ? Clock::now() : Clock::time_point{};
+                snapshot.reserve(m_queue.size());
+                for (const auto& entry : m_queue)
+                    if (!m_ttlUsed || !IsExpired(entry, now))
+                        snapshot.push_back(entry.message);
+            }
+
+            for (const auto& msg : snapshot)
+                visitor(msg);
+            return snapshot.size();
+        }
+
+        // set MessageQueue state to Closed and notify all readers/writers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            return Traced(TraceOperation::Close, [this] { return CloseImpl(); });
+        }
+
+        // TTL applied by plain Push, zero (the default) means messages never expire
+        void SetDefaultTtl(Clock::duration ttl) noexcept
+        {
+            m_defaultTtl.store(ttl.count(), std::memory_order_relaxed);
+        }
+
+        // drops every expired message at once, returns their number.
+        // not required for correctness (expired messages are skipped by Pop/Get and reclaimed before Full is reported),
+        // but gives the memory back earlier
+        std::size_t PurgeExpired()
+        {
+            std::size_t purged{ 0 };
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (!m_ttlUsed)
+                    return 0;
+                purged = RemoveExpired(Clock::now());
+            }
+            NotifyWriters(purged);
+            DeliverWatermarkEvents();
+            return purged;
+        }
+
+        // changes the capacity on the fly. no message is lost or reordered: shrinking below the current size only makes
+        // further pushes wait/fail until readers drain the queue below the new capacity
+        void Resize(std::size_t newQueueSize)
+        {
+            if (newQueueSize == 0)
+                throw std::invalid_argument{ "Invalid MessageQueue size: size should be greater than zero." };
+
+            std::size_t added{ 0 };
+            {
+                std::scoped_lock lk{ m_mtx };
+                added = newQueueSize > m_queueSize ? newQueueSize - m_queueSize : 0;
+                m_queueSize = newQueueSize;
+                RefillFromSpill();
+                UpdateReadiness();
+            }
+            // there may be free space for several blocked writers at once
+            NotifyWriters(added);
+        }
+
+        // receives messages dropped by a non-Reject overflow policy, called outside of the queue lock
+        void SetEvictionHandler(EvictionHandler handler)
+        {
+            std::scoped_lock lk{ m_mtx };
+            m_evictionHandler = std::move(handler);
+        }
+
+        // early congestion signal: the callback fires once when the depth (in-memory plus spilled messages) reaches high,
+        // and once again only after it falls back to low (hysteresis). it is called outside of the queue lock,
+        // in the crossing order, from a thread performing Push/Pop/Get. an empty callback disables the signal
+        void SetWatermarks(std::size_t high, std::size_t low, WatermarkCallback callback)
+        {
+            if (callback && low >= high)
+                throw std::invalid_argument{ "Invalid MessageQueue watermarks: low watermark should be less than high one." };
+
+            std::scoped_lock lk{ m_mtx };
+            m_watermarks.high = high;
+            m_watermarks.low = low;
+            m_watermarks.callback = std::move(callback);
+            m_watermarks.aboveHigh = false;
+            m_watermarks.pending.clear();
+            CheckWatermarks();
+        }
+
+        [[nodiscard]] Stats GetStats()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return { m_queue.size(), m_queueSize, m_highWaterMark, m_fullRejections, m_evicted, m_expired, m_delayed.size() };
+        }
+
+        // starts a new observation window, returns the high-water mark of the previous one
+        std::size_t ResetHighWaterMark()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return std::exchange(m_highWaterMark, m_queue.size());
+        }
+
+        // opt-in FIFO-fair waiting: blocked writers (Reject policy) line up like blocked readers always do, and are served
+        // in arrival order. every waiter sleeps on its own condition variable and is woken alone once it is the first in line,
+        // and newcomers (NonBlocking calls included) never overtake the ones already waiting. the price is throughput:
+        // a freed slot or a pushed message waits for the woken thread to be scheduled instead of going to whoever comes first
+        // (see the fair mode of MessageQueueBench). PushGroup, Get and the like are not ordered by the lines
+        void EnableFairWaiting()
+        {
+            std::scoped_lock lk{ m_mtx };
+            m_fairWaiting = true;
+        }
+
+        // opt-in traffic recording for offline replay (see TraceReplay.h), nullptr stops it.
+        // the recorder should outlive the recording
+        void SetTraceRecorder(TraceRecorder* recorder) noexcept
+        {
+            m_recorder.store(recorder, std::memory_order_release);
+        }
+
+#if defined(__linux__)
+        // opt-in readiness descriptors for epoll-driven clients (level-triggered, register them for EPOLLIN):
+        // the readable one is signaled while there is something to pop (or a delayed message is due, it is made visible
+        // by the following Pop), the writable one while there is some free space to push into.
+        // both are signaled once MessageQueue is closed, so the following non-blocking call reports Result::Closed
+        void EnableReadinessFds()
+        {
+            std::scoped_lock lk{ m_mtx };
+            if (m_readinessFds)
+                return;
+
+            m_readinessFds = std::make_unique<ReadinessFds>();
+            UpdateReadiness();
+        }
+
+        // returns -1 until EnableReadinessFds() is called
+        [[nodiscard]] int ReadableFd()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return m_readinessFds ? m_readinessFds->readableOrDue.Fd() : -1;
+        }
+
+        // returns -1 until EnableReadinessFds() is called
+        [[nodiscard]] int WritableFd()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return m_readinessFds ? m_readinessFds->writable.Fd() : -1;
+        }
+
+        // opt-in overflow tier: once the in-memory queue is full, messages are serialized with the provided codec and appended
+        // to memory-mapped segment files in the directory. they are fed back in FIFO order as readers drain the memory,
+        // so Push never reports Result::Full (and Blocking Push never waits) while the tier is enabled.
+        // the tier is accessed under the queue lock: a Push creating a new segment (file creation and block allocation)
+        // and page faults on the mapped segments stall other callers meanwhile. a Push that can't get a segment
+        // (e.g. the disk is full) throws std::system_error, the message isn't queued then
+        void EnableSpill(MessageCodec<Message> codec, std::string directory, std::size_t segmentSize = DefaultSpillSegmentSize)
+        {
+            if (!codec.serialize || !codec.deserialize)
+                throw std::invalid_argument{ "Invalid MessageQueue spill codec: both serialize and deserialize should be provided." };
+
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (m_spill)
+                    return;
+
+                m_spill = std::make_unique<Spill>(std::move(codec), std::move(directory), segmentSize);
+                UpdateReadiness();
+                // the turn is passed on from one writer in line to the next one
+                SignalFirst(m_pushLine);
+            }
+            // writers blocked on the full queue may proceed to the spill now
+            m_pushCv.notify_all();
+        }
+
+        [[nodiscard]] std::size_t SpilledCount()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return m_spill ? m_spill->store.Size() : 0;
+        }
+
+        // opt-in write-ahead journal: every pushed message is appended to the log at path and Push returns once it is on disk,
+        // concurrent writers share a single write+fdatasync (group commit). removals are logged too, but never awaited,
+        // so after a crash a message may be delivered again (at-least-once).
+        // messages surviving in an existing log are recovered into the queue (even beyond its size), so it should be called
+        // on startup, before MessageQueue is used (the log is replayed under the lock, nothing else runs meanwhile)
+        void EnableJournal(MessageCodec<Message> codec, std::string path, JournalOptions options = {})
+        {
+            if (!codec.serialize || !codec.deserialize)
+                throw std::invalid_argument{ "Invalid MessageQueue journal codec: both serialize and deserialize should be provided." };
+
+            // the check goes first: a second call shouldn't replace the log file the active journal appends to
+            std::scoped_lock lk{ m_mtx };
+            if (m_journal || !m_queue.empty() || !m_delayed.empty() || (m_spill && !m_spill->store.Empty()))
+                throw std::logic_error{ "MessageQueue journal should be enabled once, before MessageQueue is used." };
+
+            // removals are almost always at the head: O(1) for a deque (a vector would make the replay quadratic)
+            std::deque<std::string> recovered;
+            Journal::Replay(path, [&recovered](Journal::RecordType type, std::string_view payload)
+            {
+                if (type == Journal::RecordType::Push)
+                {
+                    recovered.emplace_back(payload);
+                }
+                else if (type == Journal::RecordType::Remove && payload.size() == sizeof(std::uint64_t))
+                {
+                    std::uint64_t position{};
+                    std::memcpy(&position, payload.data(), sizeof(position));
+                    if (position < recovered.size())
+                        recovered.erase(recovered.begin() + static_cast<std::ptrdiff_t>(position));
+                }
+            });
+            // start the new log from the surviving messages only
+            Journal::Rewrite(path, recovered);
+
+            auto journal = std::make_unique<JournalState>(std::move(codec), std::move(path), options);
+            for (const auto& msg : recovered)
+                m_queue.emplace_back(NoDeadline, journal->codec.deserialize(msg));
+            m_highWaterMark = m_queue.size();
+            m_journal = std::move(journal);
+            UpdateReadiness();
+            SignalFirst(m_popLine);
+        }
+#endif
+
+    private:
+        static constexpr Clock::time_point NoDeadline{ Clock::time_point::max() };
+        struct Entry
+        {
+            template<typename... Args>
+            explicit Entry(Clock::time_point entryDeadline, Args&&... messageCtorArgs)
+                : message(std::forward<Args>(messageCtorArgs)...)
+                , deadline{ entryDeadline }
+            {
+            }
+
+            Message message;
+            // NoDeadline for messages without TTL
+            Clock::time_point deadline;
+        };
+        // a thread blocked in line sleeps on its own condition variable, so a wakeup targets it alone
+        struct Waiter
+        {
+            std::mutex mtx;
+            std::condition_variable cv;
+            bool signaled{ false };
+            // a blocked reader's destination for a message handed over by a writer (null for writers)
+            Message* slot{ nullptr };
+            // set under the queue lock once a writer has filled the slot and taken the waiter out of line
+            std::atomic<bool> handedOff{ false };
+        };
+        struct WaitLine
+        {
+            // arrival order, protected by the queue lock. a waiter (one per thread) is shared with a writer handing a message
+            // over to it, so the writer may wake it up without any lock (the woken reader doesn't bump into one)
+            std::deque<std::shared_ptr<Waiter>> waiters;
+            // lock-free hint for notifiers running without the queue lock
+            std::atomic<std::size_t> size{ 0 };
+        };
+
+        template<OperationPolicy Policy, typename... Args>
+        Result PushImpl(Clock::time_point deadline, Args&&... messageCtorArgs)
         {
             if (IsClosed())
                 return Result::Closed;
 
+            std::uint64_t journalTicket{ 0 };
             {
                 std::unique_lock lk{ m_mtx };
-                if (m_queue.size() == m_queueSize)
+                m_ttlUsed = m_ttlUsed || deadline != NoDeadline;
+                // expired messages shouldn't make the queue look full
+                if (m_queue.size() >= m_queueSize && m_ttlUsed)
+                    ReclaimExpiredSlots();
+
+                // writers already waiting in line (fair mode) go first
+                if ((m_queue.size() >= m_queueSize && !IsSpillEnabled()) || !m_pushLine.waiters.empty())
                 {
-                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    ++m_fullRejections;
+                    if constexpr (Overflow != OverflowPolicy::Reject)
+                    {
+                        // never waits nor fails: there is always a message to sacrifice
+                        std::list<Entry> trimmed;
+                        auto evicted = PushOverflowed(journalTicket, trimmed, deadline, std::forward<Args>(messageCtorArgs)...);
+                        EvictionHandler handler = m_evictionHandler;
+                        lk.unlock();
+
+                        if (handler)
+                        {
+                            // the trimmed messages are older than the evicted one
+                            for (auto& entry : trimmed)
+                                handler(std::move(entry.message));
+                            handler(std::move(evicted));
+                        }
+                        WaitDurable(journalTicket);
+                        return Result::Ok;
+                    }
+                    else if constexpr (Policy == OperationPolicy::NonBlocking)
                     {
                         return Result::Full;
                     }
                     else
                     {
                         static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
-                        // use predicate to wait on conditions (MessageQueue is closed or there is some free space to push into) and to avoid spurious wakeup
-                        m_pushCv.wait(lk, [this] { return IsClosed() || m_queue.size() < m_queueSize; });
+                        const auto hasRoom = [this]
+                        {
+                            if (m_ttlUsed && m_queue.size() >= m_queueSize)
+                                ReclaimExpiredSlots();
+                            return m_queue.size() < m_queueSize || IsSpillEnabled();
+                        };
+                        if (m_fairWaiting && WaitInLine(lk, m_pushLine, hasRoom, [this] { return EarliestDeadline(); }) == WaitOutcome::Closed)
+                            return Result::Closed;
+
+                        // wait on conditions (MessageQueue is closed or there is some free space to push into), loop to avoid spurious wakeup.
+                        // a slot may also be freed by expiration of any queued message, so the wait is limited by the earliest deadline
+                        while (!IsClosed() && m_queue.size() >= m_queueSize && !IsSpillEnabled())
+                        {
+                            if (const auto until = EarliestDeadline(); until != NoDeadline)
+                                m_pushCv.wait_until(lk, until);
+                            else
+                                m_pushCv.wait(lk);
+
+                            if (m_ttlUsed && m_queue.size() >= m_queueSize)
+                                ReclaimExpiredSlots();
+                        }
 
                         if (IsClosed())
                             return Result::Closed;
                     }
                 }
+#if defined(__linux__)
+                // once anything is spilled, newer messages have to follow it to keep the global FIFO order
+                if (m_spill && (!m_spill->store.Empty() || m_queue.size() >= m_queueSize))
+                {
+                    const Message msg(std::forward<Args>(messageCtorArgs)...);
+                    m_spill->Append(msg, deadline);
+                    journalTicket = LogPush(msg);
+                    CheckWatermarks();
+                    // the spill has room for the next writer in line as well
+                    SignalFirst(m_pushLine);
+                    lk.unlock();
+                    WaitDurable(journalTicket);
+                    return Result::Ok;
+                }
+#endif
+                // visible delayed messages are older, they go first
+                if (!m_delayed.empty())
+                    PromoteDelayed(Clock::now());
+                // a reader is already waiting on the empty queue: the message goes straight into its slot, so the reader wakes up
+                // with the message in hand instead of taking it out of the queue under the lock once again
+                if (m_queue.empty() && !m_popLine.waiters.empty() && (deadline == NoDeadline || deadline > Clock::now()))
+                {
+                    // the reader leaves the line only once the message is built and logged: if either throws,
+                    // it is still in line to be signaled by a later Push or by Close
+                    const auto& first = m_popLine.waiters.front();
+                    *first->slot = Message(std::forward<Args>(messageCtorArgs)...);
+                    // journaled as pushed and popped at once
+                    journalTicket = LogPush(*first->slot);
+                    LogRemove(0);
+                    const auto reader = std::move(m_popLine.waiters.front());
+                    m_popLine.waiters.pop_front();
+                    m_popLine.size.store(m_popLine.waiters.size(), std::memory_order_relaxed);
+                    reader->handedOff.store(true, std::memory_order_release);
+                    // no slot is taken, the next writer in line (if any) may go on
+                    SignalFirst(m_pushLine);
+                    lk.unlock();
+                    HandOff(*reader);
+                    WaitDurable(journalTicket);
+                    return Result::Ok;
+                }
                 // add a message to the end... (FIFO) [1/2]
-                m_queue.emplace_back(std::forward<Args>(messageCtorArgs)...);
+                m_queue.emplace_back(deadline, std::forward<Args>(messageCtorArgs)...);
+                TrackDeadline(deadline);
+                m_highWaterMark = std::max(m_highWaterMark, m_queue.size());
+                journalTicket = LogPush(m_queue.back().message);
+                UpdateReadiness();
+                CheckWatermarks();
+                // after adding a message to the queue (there is something to pop) it's time to wake up a reader(if any),
+                // in fair mode the next writer in line takes the slot left (if any)
+                SignalFirst(m_popLine);
+                if (m_queue.size() < m_queueSize)
+                    SignalFirst(m_pushLine);
             }
-            // after adding a message to the queue (there is something to pop) it's time to wake up a reader(if any)
-            m_popCv.notify_one();
+            // group commit: the message is already visible to readers, the writer only waits for it to become durable
+            WaitDurable(journalTicket);
 
             return Result::Ok;
         }
 
+        // should be called under the lock when the in-memory queue is full, returns the evicted message
+        // (DropOldest also moves the excess left by a shrinking Resize into trimmed)
+        template<typename... Args>
+        Message PushOverflowed(std::uint64_t& journalTicket, std::list<Entry>& trimmed, Clock::time_point deadline, Args&&... messageCtorArgs)
+        {
+            Message evicted;
+            if constexpr (Overflow == OverflowPolicy::DropOldest)
+            {
+                // the queue may exceed its size after shrinking, trim it first: the nodes are moved out to be handed
+                // to the eviction handler outside of the lock
+                while (m_queue.size() > m_queueSize)
+                {
+                    LogRemove(0);
+                    trimmed.splice(trimmed.end(), m_queue, m_queue.begin());
+                    ++m_evicted;
+                }
+                evicted = std::move(m_queue.front().message);
+                LogRemove(0);
+                // reuse the head node as the new tail: no allocation
+                m_queue.splice(m_queue.end(), m_queue, m_queue.begin());
+                m_queue.back().message = Message(std::forward<Args>(messageCtorArgs)...);
+                m_queue.back().deadline = deadline;
+                TrackDeadline(deadline);
+                journalTicket = LogPush(m_queue.back().message);
+            }
+            else if constexpr (Overflow == OverflowPolicy::DropNewest)
+            {
+                evicted = Message(std::forward<Args>(messageCtorArgs)...);
+            }
+            else
+            {
+                static_assert(Overflow == OverflowPolicy::Overwrite, "Push: Unsupported OverflowPolicy.");
+                evicted = std::move(m_queue.back().message);
+                LogRemove(m_queue.size() - 1);
+                m_queue.back().message = Message(std::forward<Args>(messageCtorArgs)...);
+                m_queue.back().deadline = deadline;
+                TrackDeadline(deadline);
+                journalTicket = LogPush(m_queue.back().message);
+            }
+            ++m_evicted;
+            return evicted;
+        }
+
+        template<OperationPolicy Policy, typename Range>
+        Result PushGroupImpl(Range&& group)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            const auto defaultTtl = Clock::duration{ m_defaultTtl.load(std::memory_order_relaxed) };
+            const auto deadline = defaultTtl == Clock::duration::zero() ? NoDeadline : Clock::now() + defaultTtl;
+            // the nodes are built outside of the lock and spliced into the queue at once
+            std::list<Entry> entries;
+            for (auto&& msg : group)
+            {
+                if constexpr (std::is_rvalue_reference_v<Range&&>)
+                    entries.emplace_back(deadline, std::move(msg));
+                else
+                    entries.emplace_back(deadline, msg);
+            }
+            if (entries.empty())
+                return Result::Ok;
+
+            const auto result = PushEntries<Policy>(entries, deadline);
+            // a rejected group is given back to an rvalue range, so the caller may retry it
+            if constexpr (std::is_rvalue_reference_v<Range&&>)
+            {
+                if (result != Result::Ok)
+                {
+                    auto entryIt = entries.begin();
+                    for (auto&& msg : group)
+                        msg = std::move((entryIt++)->message);
+                }
+            }
+            return result;
+        }
+
+        // enqueues all the entries (spliced out of the list) or none of them
         template<OperationPolicy Policy>
-        [[nodiscard]] std::pair<Message, Result> Pop()
+        Result PushEntries(std::list<Entry>& entries, Clock::time_point deadline)
+        {
+            const auto count = entries.size();
+            std::uint64_t journalTicket{ 0 };
+            {
+                std::unique_lock lk{ m_mtx };
+                m_ttlUsed = m_ttlUsed || deadline != NoDeadline;
+                const auto fits = [this, count] { return m_queue.size() + count <= m_queueSize; };
+                // expired messages shouldn't make the queue look full
+                if (!fits() && m_ttlUsed)
+                    ReclaimExpiredSlots();
+
+                if (!fits() && !IsSpillEnabled())
+                {
+                    ++m_fullRejections;
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Full;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "PushGroup: Unsupported OperationPolicy.");
+                        // wait on conditions (MessageQueue is closed or there is room for the whole group), loop to avoid spurious wakeup.
+                        // a slot may also be freed by expiration of any queued message, so the wait is limited by the earliest deadline
+                        while (!IsClosed() && !fits() && !IsSpillEnabled())
+                        {
+                            // would never fit (until the queue is resized)
+                            if (count > m_queueSize)
+                                return Result::Full;
+
+                            // while it waits, freed slots wake every writer: a single wakeup taken by a group that still
+                            // doesn't fit would be lost for a writer behind it
+                            m_groupWritersWaiting.fetch_add(1, std::memory_order_relaxed);
+                            if (const auto until = EarliestDeadline(); until != NoDeadline)
+                                m_pushCv.wait_until(lk, until);
+                            else
+                                m_pushCv.wait(lk);
+                            m_groupWritersWaiting.fetch_sub(1, std::memory_order_relaxed);
+
+                            if (m_ttlUsed && !fits())
+                                ReclaimExpiredSlots();
+                        }
+
+                        if (IsClosed())
+                            return Result::Closed;
+                    }
+                }
+                // [entries.begin(), inMemory) goes to the in-memory queue, the rest (if any) to the spill
+                auto inMemory = entries.end();
+#if defined(__linux__)
+                // once anything is spilled, newer messages have to follow it to keep the global FIFO order.
+                // otherwise the free slots are taken first: the spill is fed back only when a message is extracted
+                if (m_spill && (!m_spill->store.Empty() || !fits()))
+                {
+                    inMemory = entries.begin();
+                    if (m_spill->store.Empty() && m_queue.size() < m_queueSize)
+                        std::advance(inMemory, std::min(count, m_queueSize - m_queue.size()));
+                    for (auto entryIt = inMemory; entryIt != entries.end(); ++entryIt)
+                        m_spill->Append(entryIt->message, entryIt->deadline);
+                }
+#endif
+                // the journal is appended in the queue order, the latest ticket covers the whole group
+                for (const auto& entry : entries)
+                    journalTicket = LogPush(entry.message);
+                if (inMemory != entries.begin())
+                    TrackDeadline(deadline);
+                m_queue.splice(m_queue.end(), entries, entries.begin(), inMemory);
+                m_highWaterMark = std::max(m_highWaterMark, m_queue.size());
+                UpdateReadiness();
+                CheckWatermarks();
+                // every reader in line passes the turn on while there is something left to pop
+                SignalFirst(m_popLine);
+            }
+            WaitDurable(journalTicket);
+
+            return Result::Ok;
+        }
+
+        template<OperationPolicy Policy>
+        std::pair<Message, Result> PopImpl()
         {
             if (IsClosed())
                 return { {}, Result::Closed };
 
             Message msg;
+            std::size_t expired{ 0 };
             {
                 std::unique_lock lk{ m_mtx };
-                if (m_queue.empty())
+                while (true)
                 {
+                    if (!m_delayed.empty())
+                        PromoteDelayed(Clock::now());
+                    // expired messages are skipped silently
+                    if (m_ttlUsed)
+                        expired += RemoveExpiredHead(Clock::now());
+                    // in fair mode readers already waiting in line go first
+                    if (!m_queue.empty() && (!m_fairWaiting || m_popLine.waiters.empty()))
+                        break;
+
                     if constexpr (Policy == OperationPolicy::NonBlocking)
                     {
+                        lk.unlock();
+                        NotifyWriters(expired);
                         return { {}, Result::Empty };
                     }
                     else
                     {
                         static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
-                        // use predicate to wait on conditions (MessageQueue is closed or there is something to pop) and to avoid spurious wakeup
-                        m_popCv.wait(lk, [this] { return IsClosed() || !m_queue.empty(); });
-
-                        if (IsClosed())
+                        // wait in line (MessageQueue is closed, a writer has handed a message over, or it's our turn and there is
+                        // something to pop). the earliest delayed message limits the waiting, it is made visible on timeout
+                        const auto hasMessage = [this, &expired]
+                        {
+                            if (!m_delayed.empty())
+                                PromoteDelayed(Clock::now());
+                            if (m_ttlUsed)
+                                expired += RemoveExpiredHead(Clock::now());
+                            return !m_queue.empty();
+                        };
+                        const auto nextVisible = [this] { return m_delayed.empty() ? NoDeadline : m_delayed.front().visibleAt; };
+                        const auto outcome = WaitInLine(lk, m_popLine, hasMessage, nextVisible, &msg);
+                        if (outcome == WaitOutcome::Closed)
                             return { {}, Result::Closed };
+                        if (outcome == WaitOutcome::HandedOff)
+                        {
+                            // the message has never been queued, only expired ones have freed their slots
+                            NotifyWriters(expired);
+                            return { std::move(msg), Result::Ok };
+                        }
+                        break;
                     }
                 }
                 // ...while pop from the beginning (FIFO) [2/2]
-                msg = std::move(m_queue.front());
+                msg = std::move(m_queue.front().message);
+                LogRemove(0);
                 m_queue.pop_front();
+                RefillFromSpill();
+                UpdateReadiness();
+                CheckWatermarks();
+                // the next reader in line takes what is left (if anything), in fair mode the first writer in line the freed slot
+                if (!m_queue.empty())
+                    SignalFirst(m_popLine);
+                SignalFirst(m_pushLine);
             }
             // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
-            m_pushCv.notify_one();
+            NotifyBlockedWriters(expired + 1);
 
             return { std::move(msg), Result::Ok };
         }
 
-        // Returns the first message that satisfies provided Predicate
         template<typename Predicate>
-        [[nodiscard]] std::pair<Message, Result> Get(Predicate&& predicate)
+        std::pair<Message, Result> GetImpl(Predicate&& predicate)
         {
             if (IsClosed())
                 return { {}, Result::Closed };
 
             Message msg;
+            std::size_t expired{ 0 };
             {
                 std::unique_lock lk{ m_mtx };
+                if (!m_delayed.empty())
+                    PromoteDelayed(Clock::now());
+                // the search is linear anyway, so expired messages are purged in bulk rather than skipped
+                if (m_ttlUsed)
+                    expired = RemoveExpired(Clock::now());
+
                 if (m_queue.empty())
+                {
+                    lk.unlock();
+                    NotifyWriters(expired);
                     return { {}, Result::Empty };
+                }
 
-                const auto msgIt = std::find_if(m_queue.begin(), m_queue.end(), std::forward<Predicate>(predicate));
+                const auto msgIt = std::find_if(m_queue.begin(), m_queue.end(), [&predicate](const Entry& entry) { return predicate(entry.message); });
                 if (msgIt == m_queue.end())
+                {
+                    lk.unlock();
+                    NotifyWriters(expired);
                     return { {}, Result::NotFound };
+                }
 
-                msg = std::move(*msgIt);
+                msg = std::move(msgIt->message);
+                LogRemove(static_cast<std::size_t>(std::distance(m_queue.begin(), msgIt)));
                 m_queue.erase(msgIt);
+                RefillFromSpill();
+                UpdateReadiness();
+                CheckWatermarks();
             }
             // after extracting a message from the queue (there is some free space to push into) it's time to wake up a writer(if any)
-            m_pushCv.notify_one();
+            NotifyWriters(expired + 1);
 
             return { std::move(msg), Result::Ok };
         }
 
-        // set MessageQueue state to Closed and notify all readers/writers (if any) about it (interrupt possible waiting)
-        Result Close() noexcept
+        // extracts matching messages (and drops expired ones on the way) in one pass, sink receives them under the lock
+        template<typename Predicate, typename Sink>
+        std::size_t ExtractIf(Predicate& predicate, Sink&& sink)
+        {
+            if (IsClosed())
+                return 0;
+
+            std::size_t extracted{ 0 };
+            std::size_t expired{ 0 };
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (!m_delayed.empty())
+                    PromoteDelayed(Clock::now());
+
+                const auto now = m_ttlUsed ? Clock::now() : Clock::time_point{};
+                std::size_t position{ 0 };
+                for (auto it = m_queue.begin(); it != m_queue.end();)
+                {
+                    const bool isExpired = m_ttlUsed && IsExpired(*it, now);
+                    if (!isExpired && !predicate(std::as_const(it->message)))
+                    {
+                        ++it;
+                        ++position;
+                        continue;
+                    }
+
+                    LogRemove(position);
+                    if (isExpired)
+                    {
+                        ++expired;
+                    }
+                    else
+                    {
+                        sink(std::move(it->message));
+                        ++extracted;
+                    }
+                    it = m_queue.erase(it);
+                }
+
+                if (extracted + expired != 0)
+                {
+                    m_expired += expired;
+                    RefillFromSpill();
+                    UpdateReadiness();
+                    CheckWatermarks();
+                }
+            }
+            // wake as many blocked writers as slots were freed
+            NotifyWriters(extracted + expired);
+            DeliverWatermarkEvents();
+
+            return extracted;
+        }
+
+        Result CloseImpl() noexcept
         {
-            m_state.store(State::Closed, std::memory_order_release);
-            m_popCv.notify_all();
+            {
+                // state is changed under the lock so a waiter can't miss the notification between its predicate check and wait
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+                UpdateReadiness();
+                for (const auto& waiter : m_popLine.waiters)
+                    Signal(*waiter);
+                for (const auto& waiter : m_pushLine.waiters)
+                    Signal(*waiter);
+            }
             m_pushCv.notify_all();
             return Result::Ok;
         }
 
-    private:
+        static Result ResultOf(Result result) noexcept
+        {
+            return result;
+        }
+
+        static Result ResultOf(const std::pair<Message, Result>& outcome) noexcept
+        {
+            return outcome.second;
+        }
+
+        // runs the operation and reports it to the trace recorder (if any)
+        template<typename Operation>
+        auto Traced(TraceOperation operation, Operation&& op)
+        {
+            auto* recorder = m_recorder.load(std::memory_order_acquire);
+            if (!recorder)
+                return op();
+
+            const auto start = TraceRecorder::Clock::now();
+            auto outcome = op();
+            recorder->Record(operation, static_cast<std::uint8_t>(ResultOf(outcome)), start, TraceRecorder::Clock::now());
+            return outcome;
+        }
+
+        // wakes as many blocked writers as slots were freed (the first writer in line too), should be called without the lock
+        void NotifyWriters(std::size_t freedSlots)
+        {
+            NotifyBlockedWriters(freedSlots);
+            if (freedSlots != 0 && m_pushLine.size.load(std::memory_order_relaxed) != 0)
+            {
+                std::scoped_lock lk{ m_mtx };
+                SignalFirst(m_pushLine);
+            }
+        }
+
+        // the same for writers waiting on the condition variable only, so it may be called under the lock as well
+        void NotifyBlockedWriters(std::size_t freedSlots) noexcept
+        {
+            if (freedSlots == 1 && m_groupWritersWaiting.load(std::memory_order_relaxed) == 0)
+                m_pushCv.notify_one();
+            else if (freedSlots != 0)
+                m_pushCv.notify_all();
+        }
+
+        enum class WaitOutcome {
+            // the caller is the first in line and ready() holds, the lock is held
+            Turn,
+            // a writer has put a message into the slot and taken the waiter out of line, the lock is released
+            HandedOff,
+            // MessageQueue is closed, the lock is held
+            Closed
+        };
+
+        // should be called under the lock: waits until the caller is the first in line and ready() holds
+        // (ready() may change the queue, e.g. drop expired messages). only the first waiter may proceed,
+        // so only it watches deadline() (head expiration, delayed visibility). the caller passes the turn on (SignalFirst)
+        // once it is done. a reader provides the slot a writer may hand a message over into
+        template<typename Ready, typename Deadline>
+        WaitOutcome WaitInLine(std::unique_lock<Lock>& lk, WaitLine& line, Ready&& ready, Deadline&& deadline, Message* slot = nullptr)
+        {
+            // a thread blocks in one line at a time, so its waiter is allocated once and reused by all its waits.
+            // a writer that has handed a message over may still signal it after the wait is over (the writer's copy
+            // keeps it alive): a later wait just wakes up spuriously then and rechecks its conditions
+            static thread_local const auto threadWaiter = std::make_shared<Waiter>();
+            const auto& waiter = threadWaiter;
+            {
+                std::scoped_lock waiterLk{ waiter->mtx };
+                waiter->signaled = false;
+            }
+            waiter->slot = slot;
+            waiter->handedOff.store(false, std::memory_order_relaxed);
+            line.waiters.push_back(waiter);
+            line.size.store(line.waiters.size(), std::memory_order_relaxed);
+            try
+            {
+                while (!IsClosed() && !(line.waiters.front() == waiter && ready()))
+                {
+                    const auto until = line.waiters.front() == waiter ? deadline() : NoDeadline;
+                    lk.unlock();
+                    Await(*waiter, until);
+                    // the message is in hand already, the queue lock isn't needed anymore
+                    if (waiter->handedOff.load(std::memory_order_acquire))
+                        return WaitOutcome::HandedOff;
+                    lk.lock();
+                    // handed over while the waiter was on its way back (e.g. after a timeout)
+                    if (waiter->handedOff.load(std::memory_order_relaxed))
+                    {
+                        lk.unlock();
+                        return WaitOutcome::HandedOff;
+                    }
+                }
+            }
+            catch (...)
+            {
+                // ready() may throw (e.g. a failed spill refill): a waiter left behind would hold the line up for good
+                // (or get a message handed over after its caller is gone), so it leaves and passes the turn on
+                if (!lk.owns_lock())
+                    lk.lock();
+                LeaveLine(line, waiter);
+                SignalFirst(line);
+                throw;
+            }
+
+            LeaveLine(line, waiter);
+            return IsClosed() ? WaitOutcome::Closed : WaitOutcome::Turn;
+        }
+
+        // should be called under the lock
+        static void LeaveLine(WaitLine& line, const std::shared_ptr<Waiter>& waiter)
+        {
+            line.waiters.erase(std::find(line.waiters.begin(), line.waiters.end(), waiter));
+            line.size.store(line.waiters.size(), std::memory_order_relaxed);
+        }
+
+        static void Await(Waiter& waiter, Clock::time_point deadline)
+        {
+            std::unique_lock lk{ waiter.mtx };
+            const auto signaled = [&waiter] { return waiter.signaled; };
+            if (deadline == NoDeadline)
+                waiter.cv.wait(lk, signaled);
+            else
+                waiter.cv.wait_until(lk, deadline, signaled);
+            waiter.signaled = false;
+        }
+
+        // should be called without any lock once the message is in the waiter's slot and the waiter is out of line,
+        // the caller keeps the waiter alive
+        static void HandOff(Waiter& waiter)
+        {
+            {
+                std::scoped_lock lk{ waiter.mtx };
+                waiter.signaled = true;
+            }
+            waiter.cv.notify_one();
+        }
+
+        // should be called under the lock (the waiter is in line, hence alive)
+        static void Signal(Waiter& waiter)
+        {
+            std::scoped_lock lk{ waiter.mtx };
+            waiter.signaled = true;
+            waiter.cv.notify_one();
+        }
+
+        // should be called under the lock, wakes the first waiter in line (if any) to check whether its turn has come
+        static void SignalFirst(WaitLine& line)
+        {
+            if (!line.waiters.empty())
+                Signal(*line.waiters.front());
+        }
+
+        // should be called under the lock, the moment the first of the queued messages may expire (NoDeadline if none does).
+        // it may be a little early (the message with the earliest deadline may be gone already), never late
+        Clock::time_point EarliestDeadline() const noexcept
+        {
+            return m_ttlUsed && !m_queue.empty() ? m_earliestDeadline : NoDeadline;
+        }
+
+        // should be called under the lock for every message put into the in-memory queue
+        void TrackDeadline(Clock::time_point deadline) noexcept
+        {
+            m_earliestDeadline = std::min(m_earliestDeadline, deadline);
+        }
+
+        bool IsExpired(const Entry& entry, Clock::time_point now) const noexcept
+        {
+            return entry.deadline <= now;
+        }
+
+        // should be called under the lock, drops expired messages at the head only (O(1) per dropped message)
+        std::size_t RemoveExpiredHead(Clock::time_point now)
+        {
+            std::size_t expired{ 0 };
+            while (!m_queue.empty() && IsExpired(m_queue.front(), now))
+            {
+                LogRemove(0);
+                m_queue.pop_front();
+                RefillFromSpill();
+                ++expired;
+            }
+
+            if (expired != 0)
+            {
+                m_expired += expired;
+                UpdateReadiness();
+                CheckWatermarks();
+            }
+            return expired;
+        }
+
+        // should be called under the lock, drops every expired message in a single pass (and refreshes the earliest deadline)
+        std::size_t RemoveExpired(Clock::time_point now)
+        {
+            std::size_t expired{ 0 };
+            std::size_t position{ 0 };
+            m_earliestDeadline = NoDeadline;
+            for (auto it = m_queue.begin(); it != m_queue.end();)
+            {
+                if (IsExpired(*it, now))
+                {
+                    LogRemove(position);
+                    it = m_queue.erase(it);
+                    ++expired;
+                }
+                else
+                {
+                    TrackDeadline(it->deadline);
+                    ++it;
+                    ++position;
+                }
+            }
+
+            if (expired != 0)
+            {
+                m_expired += expired;
+                RefillFromSpill();
+                UpdateReadiness();
+                CheckWatermarks();
+            }
+            return expired;
+        }
+
+        // should be called under the lock, moves delayed messages that became visible to the queue (while there is free space)
+        void PromoteDelayed(Clock::time_point now)
+        {
+            const auto defaultTtl = Clock::duration{ m_defaultTtl.load(std::memory_order_relaxed) };
+            bool promoted{ false };
+            while (!m_delayed.empty() && m_delayed.front().visibleAt <= now)
+            {
+                // TTL (if any) is counted from the moment the message becomes visible, wherever it goes
+                const auto deadline = defaultTtl == Clock::duration::zero() ? NoDeadline : m_delayed.front().visibleAt + defaultTtl;
+#if defined(__linux__)
+                // spilled messages are older, so a visible one has to follow them
+                if (m_spill && (!m_spill->store.Empty() || m_queue.size() >= m_queueSize))
+                {
+                    m_spill->Append(m_delayed.front().message, deadline);
+                    m_ttlUsed = m_ttlUsed || deadline != NoDeadline;
+                }
+                else
+#endif
+                if (m_queue.size() < m_queueSize)
+                {
+                    m_ttlUsed = m_ttlUsed || deadline != NoDeadline;
+                    m_queue.emplace_back(deadline, std::move(m_delayed.front().message));
+                    TrackDeadline(deadline);
+                    m_highWaterMark = std::max(m_highWaterMark, m_queue.size());
+                }
+                else
+                {
+                    break;
+                }
+
+                std::pop_heap(m_delayed.begin(), m_delayed.end(), LaterVisible{});
+                m_delayed.pop_back();
+                promoted = true;
+            }
+
+            if (promoted)
+            {
+                UpdateReadiness();
+                CheckWatermarks();
+            }
+        }
+
+        // should be called under the lock by a writer that found the queue full
+        void ReclaimExpiredSlots()
+        {
+            const auto purged = RemoveExpired(Clock::now());
+            // this writer takes one of the freed slots, other blocked writers may take the rest
+            // (the ones waiting in line get the turn passed on by this writer)
+            if (purged > 1)
+                NotifyBlockedWriters(purged - 1);
+        }
+
+        // should be called under the lock, returns a ticket to wait for durability with (zero if there is nothing to wait)
+        std::uint64_t LogPush([[maybe_unused]] const Message& msg)
+        {
+#if defined(__linux__)
+            if (m_journal)
+            {
+                m_journal->buffer.clear();
+                m_journal->codec.serialize(msg, m_journal->buffer);
+                return m_journal->journal.Append(Journal::RecordType::Push, m_journal->buffer);
+            }
+#endif
+            return 0;
+        }
+
+        // should be called under the lock with the position of a message being extracted (before the extraction)
+        void LogRemove([[maybe_unused]] std::size_t position)
+        {
+#if defined(__linux__)
+            if (!m_journal)
+                return;
+
+            const std::uint64_t value{ position };
+            m_journal->journal.Append(Journal::RecordType::Remove, std::string_view{ reinterpret_cast<const char*>(&value), sizeof(value) });
+            // the last queued message is being extracted, or a handed-over one (never queued) is: the log holds nothing alive
+            if (m_queue.size() <= 1 && (!m_spill || m_spill->store.Empty()))
+                m_journal->journal.CompactIfEmpty();
+#endif
+        }
+
+        // should be called without the lock
+        void WaitDurable([[maybe_unused]] std::uint64_t journalTicket)
+        {
+#if defined(__linux__)
+            // a non-zero ticket means the journal is enabled, and it is never disabled afterwards
+            if (journalTicket != 0)
+                m_journal->journal.WaitDurable(journalTicket);
+#endif
+        }
+
+        // should be called under the lock after every change of the queue depth, queues a watermark crossing (if any)
+        void CheckWatermarks()
+        {
+            if (!m_watermarks.callback)
+                return;
+
+            const auto depth = m_queue.size() + SpilledCountLocked();
+            if (!m_watermarks.aboveHigh && depth >= m_watermarks.high)
+                m_watermarks.aboveHigh = true;
+            else if (m_watermarks.aboveHigh && depth <= m_watermarks.low)
+                m_watermarks.aboveHigh = false;
+            else
+                return;
+
+            m_watermarks.pending.push_back({ m_watermarks.aboveHigh ? Watermark::High : Watermark::Low, depth });
+            m_watermarks.hasPending.store(true, std::memory_order_release);
+        }
+
+        // should be called without the lock. only one thread delivers at a time (draining crossings queued by others too),
+        // so callbacks are never reordered, while a callback calling back into MessageQueue doesn't dead-lock
+        void DeliverWatermarkEvents()
+        {
+            if (!m_watermarks.hasPending.load(std::memory_order_acquire))
+                return;
+
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (m_watermarks.delivering || m_watermarks.pending.empty())
+                    return;
+                m_watermarks.delivering = true;
+            }
+
+            // releases the delivery if a callback throws, a normal exit releases it together with the emptiness check
+            struct DeliveringGuard
+            {
+                ~DeliveringGuard()
+                {
+                    if (released)
+                        return;
+                    std::scoped_lock lk{ queue.m_mtx };
+                    queue.m_watermarks.delivering = false;
+                }
+                MessageQueue& queue;
+                bool released{ false };
+            } guard{ *this };
+
+            while (true)
+            {
+                WatermarkCallback callback;
+                WatermarkCrossing crossing{};
+                {
+                    std::scoped_lock lk{ m_mtx };
+                    if (m_watermarks.pending.empty())
+                    {
+                        // in the same critical section: a crossing queued after it finds nobody delivering
+                        m_watermarks.delivering = false;
+                        guard.released = true;
+                        m_watermarks.hasPending.store(false, std::memory_order_release);
+                        return;
+                    }
+                    crossing = m_watermarks.pending.front();
+                    m_watermarks.pending.pop_front();
+                    callback = m_watermarks.callback;
+                }
+                callback(crossing.watermark, crossing.depth);
+            }
+        }
+
+        std::size_t SpilledCountLocked() const noexcept
+        {
+#if defined(__linux__)
+            return m_spill ? m_spill->store.Size() : 0;
+#else
+            return 0;
+#endif
+        }
+
+        bool IsSpillEnabled() const noexcept
+        {
+#if defined(__linux__)
+            return m_spill != nullptr;
+#else
+            return false;
+#endif
+        }
+
+        bool IsJournalEnabled() const noexcept
+        {
+#if defined(__linux__)
+            return m_journal != nullptr;
+#else
+            return false;
+#endif
+        }
+
+        // should be called under the lock after a message is extracted from the in-memory queue
+        void RefillFromSpill()
+        {
+#if defined(__linux__)
+            if (!m_spill)
+                return;
+
+            while (!m_spill->store.Empty() && m_queue.size() < m_queueSize)
+            {
+                // a spilled record is the deadline followed by the serialized message
+                const auto record = m_spill->store.Front();
+                Clock::rep deadline{};
+                std::memcpy(&deadline, record.data(), sizeof(deadline));
+                m_queue.emplace_back(Clock::time_point{ Clock::duration{ deadline } }, m_spill->codec.deserialize(record.substr(sizeof(deadline))));
+                TrackDeadline(m_queue.back().deadline);
+                m_spill->store.PopFront();
+            }
+            // the refill may bring the memory depth to a level not seen since the last ResetHighWaterMark()
+            m_highWaterMark = std::max(m_highWaterMark, m_queue.size());
+#endif
+        }
+
+        // should be called under the lock after every change of the queue content or state
+        void UpdateReadiness() noexcept
+        {
+#if defined(__linux__)
+            if (!m_readinessFds)
+                return;
+
+            const bool closed = IsClosed();
+            m_readinessFds->readable.Set(closed || !m_queue.empty());
+            m_readinessFds->due.Arm(m_delayed.empty() ? NoDeadline : m_delayed.front().visibleAt);
+            m_readinessFds->writable.Set(closed || m_queue.size() < m_queueSize || IsSpillEnabled() || Overflow != OverflowPolicy::Reject);
+#endif
+        }
+
         bool IsClosed() const noexcept
         {
             return m_state.load(std::memory_order_acquire) == State::Closed;
         }
 
     private:
+        // std::condition_variable works with std::mutex only, other locks need the generic one
+        using ConditionVariable = std::conditional_t<std::is_same_v<Lock, std::mutex>, std::condition_variable, std::condition_variable_any>;
+
         // to protect shared resource (messages queue)
-        std::mutex m_mtx;
-        // to wait on condition during blocking pop (not empty condition, there is something to pop)
-        std::condition_variable m_popCv;
+        Lock m_mtx;
         // to wait on condition during blocking push (not full condition, there is some free space to push into)
-        std::condition_variable m_pushCv;
+        ConditionVariable m_pushCv;
+        // blocked PushGroup calls, changed under the lock, read by notifiers without it
+        std::atomic<std::size_t> m_groupWritersWaiting{ 0 };
+        // blocked readers always wait in line, so a writer may hand a message over to the first one directly.
+        // blocked writers wait in line in fair mode only (this line stays empty otherwise)
+        WaitLine m_popLine;
+        WaitLine m_pushLine;
+        bool m_fairWaiting{ false };
+        struct Delayed
+        {
+            Clock::time_point visibleAt;
+            // keeps push order among messages with the same visibleAt
+            std::uint64_t seq;
+            Message message;
+        };
+        struct LaterVisible
+        {
+            bool operator()(const Delayed& lhs, const Delayed& rhs) const noexcept
+            {
+                return lhs.visibleAt != rhs.visibleAt ? lhs.visibleAt > rhs.visibleAt : lhs.seq > rhs.seq;
+            }
+        };
+        // min-heap by (visibleAt, seq): O(log n) push/promotion, O(1) earliest deadline for blocked readers
+        std::vector<Delayed> m_delayed;
+        std::uint64_t m_delayedSeq{ 0 };
         // "extract from queue message that is matched client provided Predicate (any position in container)" leads to std::list is the choice
-        std::list<Message> m_queue;
+        std::list<Entry> m_queue;
         // zero size queue has no sense. so the minimum size is 1.
         std::size_t m_queueSize{ 1 };
+        struct WatermarkCrossing
+        {
+            Watermark watermark;
+            std::size_t depth;
+        };
+        struct Watermarks
+        {
+            std::size_t high{ 0 };
+            std::size_t low{ 0 };
+            WatermarkCallback callback;
+            bool aboveHigh{ false };
+            // crossings waiting to be delivered outside of the lock
+            std::deque<WatermarkCrossing> pending;
+            // lock-free hint to skip delivery when there is nothing pending
+            std::atomic<bool> hasPending{ false };
+            bool delivering{ false };
+        };
+        // protected by the same lock (except hasPending hint)
+        Watermarks m_watermarks;
+        // statistics, protected by the same lock
+        std::size_t m_highWaterMark{ 0 };
+        std::uint64_t m_fullRejections{ 0 };
+        std::uint64_t m_evicted{ 0 };
+        std::uint64_t m_expired{ 0 };
+        // set once a message with a deadline is pushed, lets TTL-free queues skip clock reads
+        bool m_ttlUsed{ false };
+        // lower bound of the queued messages deadlines: lowered on every insertion, raised back by RemoveExpired only
+        Clock::time_point m_earliestDeadline{ NoDeadline };
+        // Clock::duration ticks, atomic to read it outside of the lock
+        std::atomic<Clock::rep> m_defaultTtl{ 0 };
+        EvictionHandler m_evictionHandler;
 
         enum class State { Running, Closed };
         // state is atomic to avoid mutex lock while state checking
         std::atomic<State> m_state{ State::Running };
+        // null unless traffic is recorded
+        std::atomic<TraceRecorder*> m_recorder{ nullptr };
+
+#if defined(__linux__)
+        struct ReadinessFds
+        {
+            ReadinessFd readable;
+            ReadinessFd writable;
+            // fires once the earliest delayed message is due
+            DeadlineFd due;
+            // the descriptor exposed as readable: either there is something to pop, or a delayed message is due
+            AnyReadableFd readableOrDue{ readable.Fd(), due.Fd() };
+        };
+        // null unless readiness descriptors are enabled
+        std::unique_ptr<ReadinessFds> m_readinessFds;
+
+        static constexpr std::size_t DefaultSpillSegmentSize{ 64 * 1024 * 1024 };
+        struct Spill
+        {
+            Spill(MessageCodec<Message> spillCodec, std::string directory, std::size_t segmentSize)
+                : codec{ std::move(spillCodec) }
+                , store{ std::move(directory), segmentSize }
+            {
+            }
+
+            void Append(const Message& msg, Clock::time_point deadline)
+            {
+                // buffer is reused to avoid allocation per spilled message
+                const auto deadlineTicks = deadline.time_since_epoch().count();
+                buffer.assign(reinterpret_cast<const char*>(&deadlineTicks), sizeof(deadlineTicks));
+                codec.serialize(msg, buffer);
+                store.Append(buffer);
+            }
+
+            MessageCodec<Message> codec;
+            SpillStore store;
+            std::string buffer;
+        };
+        // null unless the overflow tier is enabled
+        std::unique_ptr<Spill> m_spill;
+
+        struct JournalState
+        {
+            JournalState(MessageCodec<Message> journalCodec, std::string path, JournalOptions options)
+                : codec{ std::move(journalCodec) }
+                , journal{ std::move(path), options }
+            {
+            }
+
+            MessageCodec<Message> codec;
+            Journal journal;
+            // reused to avoid allocation per logged message
+            std::string buffer;
+        };
+        // null unless journaling is enabled
+        std::unique_ptr<JournalState> m_journal;
+#endif
     };
 }
 
@@ -0,0 +1,202 @@
+#ifndef NUMA_H_
+#define NUMA_H_
+
+#if defined(__linux__)
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace test_task
+{
+    // NUMA placement helpers on top of raw syscalls and sysfs (no libnuma): queue storage bound to a node,
+    // and reader/writer threads pinned to its CPUs, so Push/Pop don't pay remote cache misses
+
+    // number of possible NUMA nodes (1 on a non-NUMA machine)
+    inline int NumaNodeCount()
+    {
+        // e.g. "0-1"
+        std::ifstream possible{ "/sys/devices/system/node/possible" };
+        std::string range;
+        if (!(possible >> range))
+            return 1;
+
+        const auto dash = range.find('-');
+        return dash == std::string::npos ? 1 : std::stoi(range.substr(dash + 1)) + 1;
+    }
+
+    // CPUs of a node, parsed from its sysfs cpulist (e.g. "0-3,8-11")
+    inline std::vector<int> NumaNodeCpus(int node)
+    {
+        std::ifstream cpulist{ "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist" };
+        std::string list;
+        if (!(cpulist >> list))
+            throw std::invalid_argument{ "Invalid NUMA node: node " + std::to_string(node) + " doesn't exist." };
+
+        std::vector<int> cpus;
+        std::istringstream ranges{ list };
+        for (std::string range; std::getline(ranges, range, ',');)
+        {
+            const auto dash = range.find('-');
+            const auto first = std::stoi(range.substr(0, dash));
+            const auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (auto cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    // restricts the calling thread to the provided CPUs
+    inline void PinCurrentThread(const std::vector<int>& cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const auto cpu : cpus)
+            CPU_SET(cpu, &set);
+
+        if (const auto error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); error != 0)
+            throw std::system_error{ error, std::system_category(), "PinCurrentThread: pthread_setaffinity_np failed" };
+    }
+
+    // restricts the calling thread to the CPUs of a node
+    inline void PinCurrentThreadToNode(int node)
+    {
+        PinCurrentThread(NumaNodeCpus(node));
+    }
+
+    namespace detail
+    {
+        constexpr std::size_t NodeMaskBits{ sizeof(unsigned long) * CHAR_BIT };
+
+        inline std::vector<unsigned long> NodeMask(int node)
+        {
+            if (node < 0)
+                throw std::invalid_argument{ "Invalid NUMA node: node should be non-negative." };
+
+            std::vector<unsigned long> mask(static_cast<std::size_t>(node) / NodeMaskBits + 1, 0);
+            mask.back() |= 1UL << (static_cast<std::size_t>(node) % NodeMaskBits);
+            return mask;
+        }
+
+        // the kernel drops the last bit of maxnode, so one more is passed
+        inline unsigned long MaxNode(const std::vector<unsigned long>& mask) noexcept
+        {
+            return mask.size() * NodeMaskBits + 1;
+        }
+    }
+
+    // binds the pages of [address, address + length) to a node, pages already faulted in elsewhere are moved
+    inline void BindToNumaNode(void* address, std::size_t length, int node)
+    {
+        const auto mask = detail::NodeMask(node);
+        if (syscall(SYS_mbind, address, length, MPOL_BIND, mask.data(), detail::MaxNode(mask), MPOL_MF_MOVE | MPOL_MF_STRICT) != 0)
+            throw std::system_error{ errno, std::system_category(), "BindToNumaNode: mbind failed" };
+    }
+
+    // the calling thread prefers the node for its new allocations while the object lives (set_mempolicy is per thread).
+    // useful for storage allocated on construction (e.g. RingPipeline or BroadcastQueue rings)
+    class ScopedNumaPreference final
+    {
+        ScopedNumaPreference(const ScopedNumaPreference&) = delete;
+        ScopedNumaPreference(ScopedNumaPreference&&) = delete;
+        ScopedNumaPreference& operator=(const ScopedNumaPreference&) = delete;
+        ScopedNumaPreference& operator=(ScopedNumaPreference&&) = delete;
+    public:
+        explicit ScopedNumaPreference(int node)
+        {
+            const auto mask = detail::NodeMask(node);
+            if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), detail::MaxNode(mask)) != 0)
+                throw std::system_error{ errno, std::system_category(), "ScopedNumaPreference: set_mempolicy failed" };
+        }
+
+        ~ScopedNumaPreference()
+        {
+            syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+        }
+    };
+
+    // allocator placing every allocation on its own pages bound to a node and first-touched there, so the memory
+    // doesn't end up on the node of whichever thread writes it first. page granularity makes it fit for
+    // large blocks only, e.g. UnboundedMessageQueue segments
+    template<typename T>
+    class NumaAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit NumaAllocator(int node) noexcept
+            : m_node{ node }
+        {
+        }
+
+        template<typename U>
+        NumaAllocator(const NumaAllocator<U>& other) noexcept
+            : m_node{ other.Node() }
+        {
+        }
+
+        [[nodiscard]] T* allocate(std::size_t n)
+        {
+            const auto length = n * sizeof(T);
+            void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED)
+                throw std::bad_alloc{};
+
+            try
+            {
+                BindToNumaNode(memory, length, m_node);
+            }
+            catch (...)
+            {
+                munmap(memory, length);
+                throw;
+            }
+            // first touch: fault the pages in now, under the binding
+            std::memset(memory, 0, length);
+            return static_cast<T*>(memory);
+        }
+
+        void deallocate(T* pointer, std::size_t n) noexcept
+        {
+            munmap(pointer, n * sizeof(T));
+        }
+
+        [[nodiscard]] int Node() const noexcept
+        {
+            return m_node;
+        }
+
+        template<typename U>
+        bool operator==(const NumaAllocator<U>& other) const noexcept
+        {
+            return m_node == other.Node();
+        }
+
+        template<typename U>
+        bool operator!=(const NumaAllocator<U>& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        int m_node;
+    };
+}
+
+#endif // __linux__
+
+#endif // NUMA_H_
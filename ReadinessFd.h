@@ -0,0 +1,162 @@
+#ifndef READINESS_FD_H_
+#define READINESS_FD_H_
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <system_error>
+
+namespace test_task
+{
+    // level-triggered readiness flag backed by eventfd: the descriptor is readable (EPOLLIN/POLLIN) while the flag is raised.
+    // not thread-safe by itself: an owner is expected to serialize Set() calls (e.g. under its own mutex)
+    class ReadinessFd final
+    {
+        ReadinessFd(const ReadinessFd&) = delete;
+        ReadinessFd(ReadinessFd&&) = delete;
+        ReadinessFd& operator=(const ReadinessFd&) = delete;
+        ReadinessFd& operator=(ReadinessFd&&) = delete;
+    public:
+        ReadinessFd()
+            : m_fd{ ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+        {
+            if (m_fd < 0)
+                throw std::system_error{ errno, std::system_category(), "ReadinessFd: eventfd failed" };
+        }
+
+        ~ReadinessFd()
+        {
+            ::close(m_fd);
+        }
+
+        [[nodiscard]] int Fd() const noexcept
+        {
+            return m_fd;
+        }
+
+        // the kernel is touched only on an actual transition, so a burst of raises (e.g. pushes) costs a single write
+        void Set(bool raised) noexcept
+        {
+            if (raised == m_raised)
+                return;
+
+            std::uint64_t value{ 1 };
+            // eventfd counter can't overflow (it is never incremented twice in a row) and can't be empty on lowering,
+            // so neither call is expected to fail
+            [[maybe_unused]] const auto bytes = raised ? ::write(m_fd, &value, sizeof(value)) : ::read(m_fd, &value, sizeof(value));
+            m_raised = raised;
+        }
+
+    private:
+        int m_fd{ -1 };
+        bool m_raised{ false };
+    };
+
+    // one-shot timer backed by timerfd on CLOCK_MONOTONIC (the clock of std::chrono::steady_clock): the descriptor is readable
+    // once the armed moment has passed, until it is re-armed or disarmed. not thread-safe by itself, as ReadinessFd
+    class DeadlineFd final
+    {
+        DeadlineFd(const DeadlineFd&) = delete;
+        DeadlineFd(DeadlineFd&&) = delete;
+        DeadlineFd& operator=(const DeadlineFd&) = delete;
+        DeadlineFd& operator=(DeadlineFd&&) = delete;
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        DeadlineFd()
+            : m_fd{ ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC) }
+        {
+            if (m_fd < 0)
+                throw std::system_error{ errno, std::system_category(), "DeadlineFd: timerfd_create failed" };
+        }
+
+        ~DeadlineFd()
+        {
+            ::close(m_fd);
+        }
+
+        [[nodiscard]] int Fd() const noexcept
+        {
+            return m_fd;
+        }
+
+        // Clock::time_point::max() disarms the timer. the kernel is touched only when the moment changes
+        void Arm(Clock::time_point deadline) noexcept
+        {
+            if (deadline == m_deadline)
+                return;
+
+            itimerspec spec{};
+            if (deadline != Clock::time_point::max())
+            {
+                // a zero it_value would disarm the timer, a moment in the past fires right away
+                const auto ns = std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count(), 1);
+                spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+                spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+            }
+            // (re)setting the timer drops its pending expirations, so the descriptor isn't readable anymore
+            [[maybe_unused]] const auto result = ::timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+            m_deadline = deadline;
+        }
+
+    private:
+        int m_fd{ -1 };
+        Clock::time_point m_deadline{ Clock::time_point::max() };
+    };
+
+    // epoll set over several descriptors: it is readable itself while any of them is readable, so a client may watch
+    // a combination of readiness sources as a single descriptor
+    class AnyReadableFd final
+    {
+        AnyReadableFd(const AnyReadableFd&) = delete;
+        AnyReadableFd(AnyReadableFd&&) = delete;
+        AnyReadableFd& operator=(const AnyReadableFd&) = delete;
+        AnyReadableFd& operator=(AnyReadableFd&&) = delete;
+    public:
+        explicit AnyReadableFd(std::initializer_list<int> fds)
+            : m_fd{ ::epoll_create1(EPOLL_CLOEXEC) }
+        {
+            if (m_fd < 0)
+                throw std::system_error{ errno, std::system_category(), "AnyReadableFd: epoll_create1 failed" };
+
+            for (const int fd : fds)
+            {
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.fd = fd;
+                if (::epoll_ctl(m_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+                {
+                    const int error = errno;
+                    ::close(m_fd);
+                    throw std::system_error{ error, std::system_category(), "AnyReadableFd: epoll_ctl failed" };
+                }
+            }
+        }
+
+        ~AnyReadableFd()
+        {
+            ::close(m_fd);
+        }
+
+        [[nodiscard]] int Fd() const noexcept
+        {
+            return m_fd;
+        }
+
+    private:
+        int m_fd{ -1 };
+    };
+}
+
+#endif // __linux__
+
+#endif // READINESS_FD_H_
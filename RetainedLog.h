@@ -0,0 +1,213 @@
+#ifndef RETAINED_LOG_H_
+#define RETAINED_LOG_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    struct RetentionOptions
+    {
+        // 0 means no limit, but at least one of the limits should be set
+        std::size_t maxMessages{ 0 };
+        std::size_t maxBytes{ 0 };
+    };
+
+    // log-structured sibling of MessageQueue: messages are appended at increasing offsets and stay in memory after
+    // consumption until the retention limits evict the oldest ones. every named consumer reads the log at its own offset
+    // and may Seek back to replay any retained message, e.g. to rebuild its state after a restart.
+    // retention doesn't wait for consumers: a consumer left behind the oldest retained offset resumes from it
+    template<typename Message>
+    class RetainedLog final
+    {
+        RetainedLog(const RetainedLog&) = delete;
+        RetainedLog(RetainedLog&&) = delete;
+        RetainedLog& operator=(const RetainedLog&) = delete;
+        RetainedLog& operator=(RetainedLog&&) = delete;
+    public:
+        using value_type = Message;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+        using Offset = std::uint64_t;
+        // bytes accounted to a message for RetentionOptions::maxBytes
+        using SizeOf = std::function<std::size_t(const Message&)>;
+
+        explicit RetainedLog(RetentionOptions options, SizeOf sizeOf = [](const Message&) { return sizeof(Message); })
+            : m_maxMessages{ options.maxMessages == 0 ? std::numeric_limits<std::size_t>::max() : options.maxMessages }
+            , m_maxBytes{ options.maxBytes == 0 ? std::numeric_limits<std::size_t>::max() : options.maxBytes }
+            , m_sizeOf{ std::move(sizeOf) }
+        {
+            if (options.maxMessages == 0 && options.maxBytes == 0)
+                throw std::invalid_argument{ "Invalid RetentionOptions: maxMessages or maxBytes should be greater than zero." };
+            if (!m_sizeOf)
+                throw std::invalid_argument{ "Invalid RetainedLog SizeOf: callable is expected." };
+        }
+
+        // never waits nor fails on a full log: the oldest messages are evicted instead (the newest one is always retained)
+        template<typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            // build the message and account its size outside of the lock
+            Entry entry{ Message(std::forward<Args>(messageCtorArgs)...), 0 };
+            entry.bytes = m_sizeOf(entry.message);
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_bytes += entry.bytes;
+                m_log.push_back(std::move(entry));
+                while (m_log.size() > 1 && (m_log.size() > m_maxMessages || m_bytes > m_maxBytes))
+                {
+                    m_bytes -= m_log.front().bytes;
+                    m_log.pop_front();
+                    ++m_beginOffset;
+                }
+            }
+            // every consumer may be waiting for this message
+            m_popCv.notify_all();
+
+            return Result::Ok;
+        }
+
+        // returns a copy of the message at the consumer offset and advances it.
+        // an unknown consumer starts from the oldest retained message
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop(const std::string& consumer)
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            std::unique_lock lk{ m_mtx };
+            auto& offset = ConsumerOffset(consumer);
+            if (offset == EndOffsetLocked())
+            {
+                if constexpr (Policy == OperationPolicy::NonBlocking)
+                {
+                    return { {}, Result::Empty };
+                }
+                else
+                {
+                    static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                    // use predicate to wait on conditions (RetainedLog is closed or there is something to read) and to avoid spurious wakeup.
+                    // the offset may be moved by Seek or by retention meanwhile, references into unordered_map stay valid
+                    m_popCv.wait(lk, [this, &offset] { return IsClosed() || offset != EndOffsetLocked(); });
+
+                    if (IsClosed())
+                        return { {}, Result::Closed };
+                }
+            }
+
+            // the consumer lagged behind retention
+            if (offset < m_beginOffset)
+                offset = m_beginOffset;
+
+            return { m_log[static_cast<std::size_t>(offset++ - m_beginOffset)].message, Result::Ok };
+        }
+
+        // moves the consumer (known or not) to offset, which should be in [BeginOffset(), EndOffset()].
+        // returns Result::NotFound if the offset is already evicted or not yet written
+        [[nodiscard]] Result Seek(const std::string& consumer, Offset offset)
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (offset < m_beginOffset || offset > EndOffsetLocked())
+                    return Result::NotFound;
+
+                ConsumerOffset(consumer) = offset;
+            }
+            // a blocked reader of this consumer may have something to read now
+            m_popCv.notify_all();
+
+            return Result::Ok;
+        }
+
+        // the offset of the next message the consumer will read
+        [[nodiscard]] Offset Position(const std::string& consumer)
+        {
+            std::scoped_lock lk{ m_mtx };
+            return std::max(ConsumerOffset(consumer), m_beginOffset);
+        }
+
+        // the offset of the oldest retained message
+        [[nodiscard]] Offset BeginOffset()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return m_beginOffset;
+        }
+
+        // the offset the next pushed message will get
+        [[nodiscard]] Offset EndOffset()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return EndOffsetLocked();
+        }
+
+        // set RetainedLog state to Closed and notify all readers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+            }
+            m_popCv.notify_all();
+            return Result::Ok;
+        }
+
+    private:
+        struct Entry
+        {
+            Message message;
+            std::size_t bytes;
+        };
+
+        // should be called under the lock
+        Offset EndOffsetLocked() const noexcept
+        {
+            return m_beginOffset + m_log.size();
+        }
+
+        // should be called under the lock
+        Offset& ConsumerOffset(const std::string& consumer)
+        {
+            return m_consumers.try_emplace(consumer, m_beginOffset).first->second;
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_state.load(std::memory_order_acquire) == State::Closed;
+        }
+
+    private:
+        const std::size_t m_maxMessages;
+        const std::size_t m_maxBytes;
+        SizeOf m_sizeOf;
+
+        // to protect shared resources (log, offsets and consumers)
+        std::mutex m_mtx;
+        // to wait on condition during blocking pop (there is something at the consumer offset)
+        std::condition_variable m_popCv;
+        // retained messages, m_log[i] has the offset m_beginOffset + i
+        std::deque<Entry> m_log;
+        Offset m_beginOffset{ 0 };
+        std::size_t m_bytes{ 0 };
+        // the next offset to read by every consumer
+        std::unordered_map<std::string, Offset> m_consumers;
+
+        enum class State { Running, Closed };
+        std::atomic<State> m_state{ State::Running };
+    };
+}
+
+#endif // RETAINED_LOG_H_
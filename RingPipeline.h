@@ -0,0 +1,167 @@
+#ifndef RING_PIPELINE_H_
+#define RING_PIPELINE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // Disruptor-style multi-stage pipeline: messages are written once into a preallocated ring and every stage processes
+    // them in place. each stage tracks the sequence it has processed and is gated by its predecessor (the first one by
+    // the publishing writers), writers are gated by the last stage, which thereby releases slots for reuse.
+    // no locks: sequences are atomics and waiting (Blocking policy) spins then yields.
+    // Push is enterable by several writers, each stage by one thread at a time
+    template<typename Message>
+    class RingPipeline final
+    {
+        RingPipeline(const RingPipeline&) = delete;
+        RingPipeline(RingPipeline&&) = delete;
+        RingPipeline& operator=(const RingPipeline&) = delete;
+        RingPipeline& operator=(RingPipeline&&) = delete;
+    public:
+        using value_type = Message;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+
+        // queueSize should be a power of two (sequence to slot mapping is a mask)
+        RingPipeline(std::size_t queueSize, std::size_t numOfStages)
+            : m_ring(queueSize)
+            , m_mask{ queueSize - 1 }
+            , m_stages(numOfStages)
+        {
+            if (queueSize == 0 || (queueSize & m_mask) != 0)
+                throw std::invalid_argument{ "Invalid RingPipeline size: size should be a power of two." };
+            if (numOfStages == 0)
+                throw std::invalid_argument{ "Invalid RingPipeline stages: there should be at least one stage." };
+        }
+
+        // claims the next slot, writes the message into it and publishes it to the first stage (in sequence order)
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            const auto capacity = static_cast<Sequence>(m_ring.size());
+            Sequence seq{ 0 };
+            if constexpr (Policy == OperationPolicy::NonBlocking)
+            {
+                seq = m_claim.value.load(std::memory_order_relaxed);
+                do
+                {
+                    // the slot is still in use by the pipeline until the last stage passes it
+                    if (seq - capacity > m_stages.back().value.load(std::memory_order_acquire))
+                        return Result::Full;
+                } while (!m_claim.value.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed));
+            }
+            else
+            {
+                static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
+                seq = m_claim.value.fetch_add(1, std::memory_order_relaxed);
+                if (!WaitFor([this, seq, capacity] { return seq - capacity <= m_stages.back().value.load(std::memory_order_acquire); }))
+                    return Result::Closed;
+            }
+
+            m_ring[static_cast<std::size_t>(seq) & m_mask] = Message(std::forward<Args>(messageCtorArgs)...);
+
+            // writers publish in claim order, so the first stage never sees a gap
+            if (!WaitFor([this, seq] { return m_published.value.load(std::memory_order_acquire) == seq - 1; }))
+                return Result::Closed;
+            m_published.value.store(seq, std::memory_order_release);
+
+            return Result::Ok;
+        }
+
+        // calls handler(Message&) for every message released by the previous stage (writers for the stage 0)
+        // and not processed by this stage yet, then releases them to the next stage at once.
+        // returns the number of processed messages, Result::Empty if there was nothing to process (NonBlocking only)
+        template<OperationPolicy Policy, typename Handler>
+        [[nodiscard]] std::pair<std::size_t, Result> Process(std::size_t stage, Handler&& handler)
+        {
+            if (IsClosed())
+                return { 0, Result::Closed };
+
+            auto& cursor = m_stages.at(stage).value;
+            const auto& barrier = stage == 0 ? m_published.value : m_stages[stage - 1].value;
+            const auto next = cursor.load(std::memory_order_relaxed) + 1;
+
+            auto available = barrier.load(std::memory_order_acquire);
+            if (available < next)
+            {
+                if constexpr (Policy == OperationPolicy::NonBlocking)
+                {
+                    return { 0, Result::Empty };
+                }
+                else
+                {
+                    static_assert(Policy == OperationPolicy::Blocking, "Process: Unsupported OperationPolicy.");
+                    if (!WaitFor([&barrier, &available, next] { return (available = barrier.load(std::memory_order_acquire)) >= next; }))
+                        return { 0, Result::Closed };
+                }
+            }
+
+            for (auto seq = next; seq <= available; ++seq)
+                handler(m_ring[static_cast<std::size_t>(seq) & m_mask]);
+            cursor.store(available, std::memory_order_release);
+
+            return { static_cast<std::size_t>(available - next + 1), Result::Ok };
+        }
+
+        // set RingPipeline state to Closed: further push/process are impossible, waiting writers and stages are interrupted
+        Result Close() noexcept
+        {
+            m_closed.store(true, std::memory_order_release);
+            return Result::Ok;
+        }
+
+    private:
+        using Sequence = std::int64_t;
+
+        // every sequence lives on its own cache line, so stages don't invalidate each other's lines on every update
+        struct alignas(64) PaddedSequence
+        {
+            std::atomic<Sequence> value{ -1 };
+        };
+
+        bool IsClosed() const noexcept
+        {
+            return m_closed.load(std::memory_order_acquire);
+        }
+
+        // returns false if RingPipeline is closed while waiting
+        template<typename Ready>
+        bool WaitFor(Ready&& ready) const
+        {
+            for (std::size_t spins = 0; !ready(); ++spins)
+            {
+                if (IsClosed())
+                    return false;
+                // busy-spin briefly (the other side is usually a few instructions away), then give the core away
+                if (spins >= SpinsBeforeYield)
+                    std::this_thread::yield();
+            }
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t SpinsBeforeYield{ 64 };
+
+        std::vector<Message> m_ring;
+        const std::size_t m_mask;
+        // the next sequence to claim by a writer
+        PaddedSequence m_claim{ 0 };
+        // the last sequence published by writers
+        PaddedSequence m_published;
+        // the last sequence processed by every stage
+        std::vector<PaddedSequence> m_stages;
+        std::atomic<bool> m_closed{ false };
+    };
+}
+
+#endif // RING_PIPELINE_H_
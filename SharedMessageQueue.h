@@ -0,0 +1,314 @@
+#ifndef SHARED_MESSAGE_QUEUE_H_
+#define SHARED_MESSAGE_QUEUE_H_
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // interprocess counterpart of MessageQueue: the ring, its indices and the close state live in a named shm_open/mmap region,
+    // so a writer and a reader may be different processes. messages are copied bytewise, hence they must be trivially copyable.
+    // the creating process owns the region name and unlinks it on destruction, other processes just attach to it by name
+    template<typename Message>
+    class SharedMessageQueue final
+    {
+        static_assert(std::is_trivially_copyable_v<Message>, "SharedMessageQueue: Message should be trivially copyable.");
+        static_assert(std::is_default_constructible_v<Message>, "SharedMessageQueue: Message should be default constructible.");
+
+        SharedMessageQueue(const SharedMessageQueue&) = delete;
+        SharedMessageQueue(SharedMessageQueue&&) = delete;
+        SharedMessageQueue& operator=(const SharedMessageQueue&) = delete;
+        SharedMessageQueue& operator=(SharedMessageQueue&&) = delete;
+    public:
+        using value_type = Message;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+
+        // creates a new region (fails if the name is already taken), name should follow shm_open rules ("/name")
+        SharedMessageQueue(std::string name, std::size_t queueSize)
+            : m_name{ std::move(name) }
+            , m_ownerPid{ ::getpid() }
+        {
+            if (queueSize == 0)
+                throw std::invalid_argument{ "Invalid SharedMessageQueue size: size should be greater than zero." };
+
+            const int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+                throw std::system_error{ errno, std::system_category(), "SharedMessageQueue: shm_open failed" };
+
+            m_mappingSize = RingOffset() + queueSize * sizeof(Message);
+            if (::ftruncate(fd, static_cast<off_t>(m_mappingSize)) != 0)
+            {
+                const int error = errno;
+                ::close(fd);
+                ::shm_unlink(m_name.c_str());
+                throw std::system_error{ error, std::system_category(), "SharedMessageQueue: ftruncate failed" };
+            }
+
+            try
+            {
+                Map(fd);
+                InitHeader(queueSize);
+            }
+            catch (...)
+            {
+                ::shm_unlink(m_name.c_str());
+                throw;
+            }
+        }
+
+        // attaches to a region previously created by another SharedMessageQueue instance
+        explicit SharedMessageQueue(std::string name)
+            : m_name{ std::move(name) }
+        {
+            const int fd = ::shm_open(m_name.c_str(), O_RDWR, 0);
+            if (fd < 0)
+                throw std::system_error{ errno, std::system_category(), "SharedMessageQueue: shm_open failed" };
+
+            struct stat st {};
+            if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < RingOffset())
+            {
+                ::close(fd);
+                throw std::runtime_error{ "SharedMessageQueue: region is not initialized." };
+            }
+
+            m_mappingSize = static_cast<std::size_t>(st.st_size);
+            Map(fd);
+            if (m_header->magic.load(std::memory_order_acquire) != Magic)
+            {
+                ::munmap(m_header, m_mappingSize);
+                throw std::runtime_error{ "SharedMessageQueue: region is not initialized." };
+            }
+
+            // the ring is addressed by the header's queueSize, so a region created for another Message type
+            // or truncated afterwards would be accessed out of the mapping
+            if (m_header->messageSize != sizeof(Message) || m_header->queueSize > (m_mappingSize - RingOffset()) / sizeof(Message))
+            {
+                ::munmap(m_header, m_mappingSize);
+                throw std::runtime_error{ "SharedMessageQueue: region doesn't match the Message type or is truncated." };
+            }
+        }
+
+        ~SharedMessageQueue()
+        {
+            ::munmap(m_header, m_mappingSize);
+            // a fork()ed child inherits the owner's object, only the creating process removes the name
+            if (m_ownerPid == ::getpid())
+                ::shm_unlink(m_name.c_str());
+        }
+
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            {
+                Lock lk{ *m_header };
+                if (m_header->count == m_header->queueSize)
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return Result::Full;
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Push: Unsupported OperationPolicy.");
+                        while (!IsClosed() && m_header->count == m_header->queueSize)
+                            lk.Wait(m_header->pushCv);
+
+                        if (IsClosed())
+                            return Result::Closed;
+                    }
+                }
+                // add a message to the end... (FIFO) [1/2]
+                const auto tail = (m_header->head + m_header->count) % m_header->queueSize;
+                new (Ring() + tail) Message(std::forward<Args>(messageCtorArgs)...);
+                ++m_header->count;
+            }
+            ::pthread_cond_signal(&m_header->popCv);
+
+            return Result::Ok;
+        }
+
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop()
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            Message msg;
+            {
+                Lock lk{ *m_header };
+                if (m_header->count == 0)
+                {
+                    if constexpr (Policy == OperationPolicy::NonBlocking)
+                    {
+                        return { {}, Result::Empty };
+                    }
+                    else
+                    {
+                        static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                        while (!IsClosed() && m_header->count == 0)
+                            lk.Wait(m_header->popCv);
+
+                        if (IsClosed())
+                            return { {}, Result::Closed };
+                    }
+                }
+                // ...while pop from the beginning (FIFO) [2/2]
+                msg = Ring()[m_header->head];
+                m_header->head = (m_header->head + 1) % m_header->queueSize;
+                --m_header->count;
+            }
+            ::pthread_cond_signal(&m_header->pushCv);
+
+            return { msg, Result::Ok };
+        }
+
+        // closes MessageQueue for every attached process
+        Result Close() noexcept
+        {
+            {
+                Lock lk{ *m_header };
+                m_header->state.store(Closed, std::memory_order_release);
+            }
+            ::pthread_cond_broadcast(&m_header->popCv);
+            ::pthread_cond_broadcast(&m_header->pushCv);
+            return Result::Ok;
+        }
+
+    private:
+        static constexpr std::uint32_t Magic{ 0x4d51534d }; // "MQSM"
+        static constexpr std::uint32_t Running{ 0 };
+        static constexpr std::uint32_t Closed{ 1 };
+
+        // lives at the beginning of the shared region, followed by the ring of messages
+        struct Header
+        {
+            pthread_mutex_t mtx;
+            pthread_cond_t popCv;
+            pthread_cond_t pushCv;
+            std::size_t queueSize;
+            // sizeof(Message) of the creator, checked on attach
+            std::size_t messageSize;
+            std::size_t head;
+            std::size_t count;
+            std::atomic<std::uint32_t> state;
+            // set last, so an attaching process never sees a half-initialized header
+            std::atomic<std::uint32_t> magic;
+        };
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "SharedMessageQueue: state should be address-free.");
+
+        // robust process-shared mutex guard: a peer that died while holding the lock doesn't dead-lock the others
+        class Lock final
+        {
+        public:
+            explicit Lock(Header& header) noexcept
+                : m_mtx{ header.mtx }
+            {
+                if (::pthread_mutex_lock(&m_mtx) == EOWNERDEAD)
+                    ::pthread_mutex_consistent(&m_mtx);
+            }
+
+            ~Lock()
+            {
+                ::pthread_mutex_unlock(&m_mtx);
+            }
+
+            void Wait(pthread_cond_t& cv) noexcept
+            {
+                if (::pthread_cond_wait(&cv, &m_mtx) == EOWNERDEAD)
+                    ::pthread_mutex_consistent(&m_mtx);
+            }
+
+        private:
+            pthread_mutex_t& m_mtx;
+        };
+
+        static constexpr std::size_t RingOffset() noexcept
+        {
+            return (sizeof(Header) + alignof(Message) - 1) / alignof(Message) * alignof(Message);
+        }
+
+        void Map(int fd)
+        {
+            void* addr = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            const int error = errno;
+            ::close(fd);
+            if (addr == MAP_FAILED)
+                throw std::system_error{ error, std::system_category(), "SharedMessageQueue: mmap failed" };
+
+            m_header = static_cast<Header*>(addr);
+        }
+
+        void InitHeader(std::size_t queueSize)
+        {
+            pthread_mutexattr_t mtxAttr;
+            ::pthread_mutexattr_init(&mtxAttr);
+            ::pthread_mutexattr_setpshared(&mtxAttr, PTHREAD_PROCESS_SHARED);
+            ::pthread_mutexattr_setrobust(&mtxAttr, PTHREAD_MUTEX_ROBUST);
+            const int mtxError = ::pthread_mutex_init(&m_header->mtx, &mtxAttr);
+            ::pthread_mutexattr_destroy(&mtxAttr);
+
+            pthread_condattr_t cvAttr;
+            ::pthread_condattr_init(&cvAttr);
+            ::pthread_condattr_setpshared(&cvAttr, PTHREAD_PROCESS_SHARED);
+            const int popCvError = ::pthread_cond_init(&m_header->popCv, &cvAttr);
+            const int pushCvError = ::pthread_cond_init(&m_header->pushCv, &cvAttr);
+            ::pthread_condattr_destroy(&cvAttr);
+
+            if (mtxError != 0 || popCvError != 0 || pushCvError != 0)
+            {
+                ::munmap(m_header, m_mappingSize);
+                throw std::system_error{ mtxError ? mtxError : (popCvError ? popCvError : pushCvError), std::system_category(),
+                    "SharedMessageQueue: synchronization primitives initialization failed" };
+            }
+
+            m_header->queueSize = queueSize;
+            m_header->messageSize = sizeof(Message);
+            m_header->head = 0;
+            m_header->count = 0;
+            new (&m_header->state) std::atomic<std::uint32_t>{ Running };
+            new (&m_header->magic) std::atomic<std::uint32_t>{ 0 };
+            m_header->magic.store(Magic, std::memory_order_release);
+        }
+
+        Message* Ring() const noexcept
+        {
+            return reinterpret_cast<Message*>(reinterpret_cast<unsigned char*>(m_header) + RingOffset());
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_header->state.load(std::memory_order_acquire) == Closed;
+        }
+
+    private:
+        std::string m_name;
+        // only the creator unlinks the region, zero for attached instances
+        pid_t m_ownerPid{ 0 };
+        std::size_t m_mappingSize{ 0 };
+        Header* m_header{ nullptr };
+    };
+}
+
+#endif // __linux__
+
+#endif // SHARED_MESSAGE_QUEUE_H_
@@ -0,0 +1,153 @@
+#ifndef SPILL_STORE_H_
+#define SPILL_STORE_H_
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace test_task
+{
+    // FIFO of byte records kept in memory-mapped segment files.
+    // segment files are unlinked right after creation: the spilled data is an extension of the in-memory queue (not a durable copy),
+    // so nothing is left on disk after the process is gone. not thread-safe by itself, the owner serializes access
+    class SpillStore final
+    {
+        SpillStore(const SpillStore&) = delete;
+        SpillStore(SpillStore&&) = delete;
+        SpillStore& operator=(const SpillStore&) = delete;
+        SpillStore& operator=(SpillStore&&) = delete;
+    public:
+        SpillStore(std::string directory, std::size_t segmentSize)
+            : m_directory{ std::move(directory) }
+            , m_segmentSize{ segmentSize }
+        {
+            if (segmentSize <= sizeof(RecordSize))
+                throw std::invalid_argument{ "Invalid SpillStore segment size: size should be greater than record header." };
+        }
+
+        ~SpillStore()
+        {
+            for (const auto& segment : m_segments)
+                ::munmap(segment.base, segment.capacity);
+        }
+
+        [[nodiscard]] bool Empty() const noexcept
+        {
+            return m_count == 0;
+        }
+
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return m_count;
+        }
+
+        // throws std::system_error (e.g. with ENOSPC) when a new segment can't be created, the store is left unchanged
+        void Append(std::string_view record)
+        {
+            if (record.size() > UINT32_MAX)
+                throw std::length_error{ "SpillStore: record is too large." };
+
+            const std::size_t required = sizeof(RecordSize) + record.size();
+            if (m_segments.empty() || m_segments.back().capacity - m_segments.back().writeOffset < required)
+                m_segments.push_back(MapSegment(std::max(m_segmentSize, required)));
+
+            auto& segment = m_segments.back();
+            const auto size = static_cast<RecordSize>(record.size());
+            std::memcpy(segment.base + segment.writeOffset, &size, sizeof(size));
+            std::memcpy(segment.base + segment.writeOffset + sizeof(size), record.data(), record.size());
+            segment.writeOffset += required;
+            ++m_count;
+        }
+
+        // returned view is valid until the next Append/PopFront call
+        [[nodiscard]] std::string_view Front() const noexcept
+        {
+            const auto& segment = m_segments.front();
+            RecordSize size{};
+            std::memcpy(&size, segment.base + segment.readOffset, sizeof(size));
+            return { segment.base + segment.readOffset + sizeof(size), size };
+        }
+
+        void PopFront() noexcept
+        {
+            auto& segment = m_segments.front();
+            segment.readOffset += sizeof(RecordSize) + Front().size();
+            --m_count;
+
+            if (segment.readOffset != segment.writeOffset)
+                return;
+
+            if (m_segments.size() == 1)
+            {
+                // the only segment is drained: rewind it instead of mapping a new one
+                segment.readOffset = segment.writeOffset = 0;
+            }
+            else
+            {
+                ::munmap(segment.base, segment.capacity);
+                m_segments.pop_front();
+            }
+        }
+
+    private:
+        using RecordSize = std::uint32_t;
+
+        struct Segment
+        {
+            char* base;
+            std::size_t capacity;
+            std::size_t readOffset;
+            std::size_t writeOffset;
+        };
+
+        Segment MapSegment(std::size_t capacity) const
+        {
+            auto path = m_directory + "/mq-spill-XXXXXX";
+            const int fd = ::mkstemp(path.data());
+            if (fd < 0)
+                throw std::system_error{ errno, std::system_category(), "SpillStore: segment creation failed" };
+            ::unlink(path.c_str());
+
+            // the blocks are reserved up front: writing a sparse file through the mapping would raise SIGBUS on a full disk
+            // instead of reporting an error here
+            const int allocateError = ::posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+            if (allocateError != 0)
+            {
+                ::close(fd);
+                throw std::system_error{ allocateError, std::system_category(), "SpillStore: segment allocation failed" };
+            }
+
+            void* base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            const int error = errno;
+            ::close(fd);
+            if (base == MAP_FAILED)
+                throw std::system_error{ error, std::system_category(), "SpillStore: segment mapping failed" };
+
+            return { static_cast<char*>(base), capacity, 0, 0 };
+        }
+
+    private:
+        std::string m_directory;
+        std::size_t m_segmentSize{ 0 };
+        // segments are written at the back and read from the front
+        std::deque<Segment> m_segments;
+        std::size_t m_count{ 0 };
+    };
+}
+
+#endif // __linux__
+
+#endif // SPILL_STORE_H_
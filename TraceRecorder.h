@@ -0,0 +1,141 @@
+#ifndef TRACE_RECORDER_H_
+#define TRACE_RECORDER_H_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace test_task
+{
+    enum class TraceOperation : std::uint8_t {
+        PushBlocking,
+        PushNonBlocking,
+        PopBlocking,
+        PopNonBlocking,
+        Get,
+        Close
+    };
+
+    // one record of a binary trace, stored as is (no padding bytes)
+    struct TraceEvent
+    {
+        // since the recorder creation
+        std::uint64_t startNs;
+        std::uint64_t durationNs;
+        // dense per-process thread number (0, 1, 2...), stable for the thread lifetime
+        std::uint32_t threadId;
+        TraceOperation operation;
+        // test_task::Result value
+        std::uint8_t result;
+        std::uint16_t reserved;
+    };
+    static_assert(sizeof(TraceEvent) == 24, "TraceEvent: unexpected padding.");
+
+    // thread-safe sink of queue events writing a compact binary trace: a file header followed by TraceEvent records
+    class TraceRecorder final
+    {
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder(TraceRecorder&&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(TraceRecorder&&) = delete;
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit TraceRecorder(const std::string& path)
+            : m_file{ std::fopen(path.c_str(), "wb") }
+        {
+            if (!m_file)
+                throw std::system_error{ errno, std::system_category(), "TraceRecorder: fopen failed" };
+
+            std::fwrite(FileMagic, sizeof(FileMagic), 1, m_file);
+            m_buffer.reserve(BufferCapacity);
+        }
+
+        ~TraceRecorder()
+        {
+            Flush();
+            std::fclose(m_file);
+        }
+
+        // never fails the traced operation: the buffer is preallocated and flushed before it overflows
+        void Record(TraceOperation operation, std::uint8_t result, Clock::time_point start, Clock::time_point end) noexcept
+        {
+            TraceEvent event{};
+            event.startNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_origin).count());
+            event.durationNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            event.threadId = CurrentThreadId();
+            event.operation = operation;
+            event.result = result;
+
+            std::scoped_lock lk{ m_mtx };
+            if (m_buffer.size() == BufferCapacity)
+                FlushLocked();
+            // never reallocates, the capacity is reserved upfront
+            m_buffer.push_back(event);
+        }
+
+        void Flush()
+        {
+            std::scoped_lock lk{ m_mtx };
+            FlushLocked();
+            std::fflush(m_file);
+        }
+
+        // events of a trace file in the recorded order
+        static std::vector<TraceEvent> Load(const std::string& path)
+        {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                throw std::system_error{ errno, std::system_category(), "TraceRecorder: fopen failed" };
+
+            char magic[sizeof(FileMagic)]{};
+            if (std::fread(magic, sizeof(magic), 1, file) != 1 || std::memcmp(magic, FileMagic, sizeof(magic)) != 0)
+            {
+                std::fclose(file);
+                throw std::runtime_error{ "TraceRecorder: not a trace file." };
+            }
+
+            std::vector<TraceEvent> events;
+            TraceEvent event{};
+            while (std::fread(&event, sizeof(event), 1, file) == 1)
+                events.push_back(event);
+            std::fclose(file);
+
+            return events;
+        }
+
+    private:
+        static constexpr char FileMagic[8]{ 'M', 'Q', 'T', 'R', 'A', 'C', 'E', '1' };
+        static constexpr std::size_t BufferCapacity{ 4096 };
+
+        static std::uint32_t CurrentThreadId() noexcept
+        {
+            static std::atomic<std::uint32_t> nextId{ 0 };
+            thread_local const std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+            return id;
+        }
+
+        void FlushLocked() noexcept
+        {
+            std::fwrite(m_buffer.data(), sizeof(TraceEvent), m_buffer.size(), m_file);
+            m_buffer.clear();
+        }
+
+    private:
+        const Clock::time_point m_origin{ Clock::now() };
+        std::FILE* m_file{ nullptr };
+        // to protect buffer and file
+        std::mutex m_mtx;
+        std::vector<TraceEvent> m_buffer;
+    };
+}
+
+#endif // TRACE_RECORDER_H_
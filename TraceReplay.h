@@ -0,0 +1,153 @@
+#ifndef TRACE_REPLAY_H_
+#define TRACE_REPLAY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MessageQueue.h"
+#include "TraceRecorder.h"
+
+namespace test_task
+{
+    enum class ReplayTiming {
+        // every event starts at its recorded offset from the trace beginning (keeps the original inter-arrival times)
+        Original,
+        // every replay thread issues its events back to back
+        AsFastAsPossible
+    };
+
+    struct ReplayOptions
+    {
+        ReplayTiming timing{ ReplayTiming::Original };
+        // a trace without Close may leave replay threads blocked (e.g. the backend under test drains faster than the recorded one):
+        // once nothing has progressed for this long, the queue is closed to release them
+        std::chrono::milliseconds stallTimeout{ 200 };
+    };
+
+    struct ReplayReport
+    {
+        std::size_t events{ 0 };
+        // events whose result differs from the recorded one
+        std::size_t mismatches{ 0 };
+        std::chrono::nanoseconds elapsed{ 0 };
+        // sum of per-event durations, to compare backends on the same traffic shape
+        std::chrono::nanoseconds busy{ 0 };
+    };
+
+    namespace detail
+    {
+        template<typename Queue, typename = void>
+        struct HasGet : std::false_type {};
+
+        template<typename Queue>
+        struct HasGet<Queue, std::void_t<decltype(std::declval<Queue&>().Get(std::declval<bool(*)(const typename Queue::value_type&)>()))>>
+            : std::true_type {};
+    }
+
+    // re-executes a recorded trace against any queue backend exposing MessageQueue interface (Push/Pop/Close and optionally Get),
+    // one replay thread per recorded thread. pushed messages are produced by makeMessage(), Get takes the first message.
+    template<typename Queue, typename MakeMessage>
+    ReplayReport ReplayTrace(const std::vector<TraceEvent>& events, Queue& queue, MakeMessage&& makeMessage, ReplayOptions options = {})
+    {
+        using Policy = typename Queue::OperationPolicy;
+        using Clock = std::chrono::steady_clock;
+
+        std::map<std::uint32_t, std::vector<TraceEvent>> perThread;
+        for (const auto& event : events)
+            perThread[event.threadId].push_back(event);
+
+        std::atomic<std::size_t> mismatches{ 0 };
+        std::atomic<std::int64_t> busyNs{ 0 };
+        // bumped on every finished event, watched to detect a stalled replay
+        std::atomic<std::size_t> progress{ 0 };
+        std::atomic<std::size_t> finishedThreads{ 0 };
+
+        const auto execute = [&queue, &makeMessage](TraceOperation operation) -> Result
+        {
+            switch (operation)
+            {
+            case TraceOperation::PushBlocking:
+                return queue.template Push<Policy::Blocking>(makeMessage());
+            case TraceOperation::PushNonBlocking:
+                return queue.template Push<Policy::NonBlocking>(makeMessage());
+            case TraceOperation::PopBlocking:
+                return queue.template Pop<Policy::Blocking>().second;
+            case TraceOperation::PopNonBlocking:
+                return queue.template Pop<Policy::NonBlocking>().second;
+            case TraceOperation::Get:
+                if constexpr (detail::HasGet<Queue>::value)
+                    return queue.Get([](const auto&) { return true; }).second;
+                else
+                    return queue.template Pop<Policy::NonBlocking>().second;
+            case TraceOperation::Close:
+                return queue.Close();
+            }
+            return Result::NotFound;
+        };
+
+        const auto start = Clock::now();
+        std::vector<std::thread> threads;
+        threads.reserve(perThread.size());
+        for (const auto& [threadId, threadEvents] : perThread)
+        {
+            threads.emplace_back([&, &threadEvents = threadEvents]
+            {
+                for (const auto& event : threadEvents)
+                {
+                    if (options.timing == ReplayTiming::Original)
+                        std::this_thread::sleep_until(start + std::chrono::nanoseconds{ event.startNs });
+
+                    const auto eventStart = Clock::now();
+                    const auto result = execute(event.operation);
+                    busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - eventStart).count(), std::memory_order_relaxed);
+
+                    if (static_cast<std::uint8_t>(result) != event.result)
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                    progress.fetch_add(1, std::memory_order_relaxed);
+                }
+                finishedThreads.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        const auto traceEnd = events.empty() ? std::chrono::nanoseconds{ 0 } : std::chrono::nanoseconds{ std::max_element(events.begin(), events.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.startNs < rhs.startNs; })->startNs };
+        auto lastProgress = progress.load(std::memory_order_relaxed);
+        auto lastProgressTime = Clock::now();
+        while (finishedThreads.load(std::memory_order_acquire) != threads.size())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+            const auto now = Clock::now();
+            const auto currentProgress = progress.load(std::memory_order_relaxed);
+            if (currentProgress != lastProgress)
+            {
+                lastProgress = currentProgress;
+                lastProgressTime = now;
+            }
+            else if (now - lastProgressTime > options.stallTimeout && (options.timing == ReplayTiming::AsFastAsPossible || now - start > traceEnd))
+            {
+                queue.Close();
+                break;
+            }
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        ReplayReport report;
+        report.events = events.size();
+        report.mismatches = mismatches.load();
+        report.elapsed = Clock::now() - start;
+        report.busy = std::chrono::nanoseconds{ busyNs.load() };
+        return report;
+    }
+}
+
+#endif // TRACE_REPLAY_H_
@@ -0,0 +1,258 @@
+#ifndef UNBOUNDED_MESSAGE_QUEUE_H_
+#define UNBOUNDED_MESSAGE_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "MessageQueue.h"
+
+namespace test_task
+{
+    // MessageQueue flavour that never rejects: messages live in fixed-size segments (SegmentSize slots each) linked into
+    // a FIFO, so there is no allocation per message, and drained segments are recycled through a free list, so a queue
+    // oscillating around its working size doesn't allocate at all. an optional soft cap doesn't limit the queue,
+    // it only raises a backpressure signal writers may poll. segments are obtained from Allocator
+    template<typename Message, std::size_t SegmentSize = 1024, typename Allocator = std::allocator<Message>>
+    class UnboundedMessageQueue final
+    {
+        static_assert(SegmentSize > 0, "UnboundedMessageQueue: SegmentSize should be greater than zero.");
+
+        UnboundedMessageQueue(const UnboundedMessageQueue&) = delete;
+        UnboundedMessageQueue(UnboundedMessageQueue&&) = delete;
+        UnboundedMessageQueue& operator=(const UnboundedMessageQueue&) = delete;
+        UnboundedMessageQueue& operator=(UnboundedMessageQueue&&) = delete;
+    public:
+        using value_type = Message;
+        using allocator_type = Allocator;
+        using OperationPolicy = typename MessageQueue<Message>::OperationPolicy;
+
+        struct Stats
+        {
+            std::size_t size;
+            std::size_t softCap;
+            std::size_t highWaterMark;
+            // segments in use and kept in the free list
+            std::size_t segments;
+            std::size_t freeSegments;
+            // pushes that found the queue at or above the soft cap
+            std::uint64_t softCapExceeded;
+        };
+
+        // zero softCap means there is no backpressure signal at all
+        explicit UnboundedMessageQueue(std::size_t softCap = 0, const Allocator& allocator = Allocator{})
+            : m_allocator{ allocator }
+            , m_softCap{ softCap }
+        {
+            m_head = m_tail = AcquireSegment();
+        }
+
+        ~UnboundedMessageQueue()
+        {
+            while (m_size != 0)
+                PopFront();
+            ReleaseSegment(m_head);
+            while (m_free)
+                ReleaseSegment(std::exchange(m_free, m_free->next));
+        }
+
+        // never waits nor reports Result::Full, Policy is accepted for interface compatibility with MessageQueue
+        template<OperationPolicy Policy, typename... Args>
+        [[nodiscard]] Result Push(Args&&... messageCtorArgs)
+        {
+            if (IsClosed())
+                return Result::Closed;
+
+            {
+                std::scoped_lock lk{ m_mtx };
+                if (m_tailIndex == SegmentSize)
+                {
+                    // a recycled segment is taken when there is one, so allocation happens only while the queue grows
+                    m_tail->next = AcquireSegment();
+                    m_tail = m_tail->next;
+                    m_tailIndex = 0;
+                }
+                // add a message to the end... (FIFO) [1/2]
+                ::new (static_cast<void*>(m_tail->Slot(m_tailIndex))) Message(std::forward<Args>(messageCtorArgs)...);
+                ++m_tailIndex;
+                ++m_size;
+                m_highWaterMark = std::max(m_highWaterMark, m_size);
+                if (m_softCap != 0 && m_size >= m_softCap)
+                    ++m_softCapExceeded;
+                UpdateAboveSoftCap();
+            }
+            // after adding a message to the queue (there is something to pop) it's time to wake up a reader(if any)
+            m_popCv.notify_one();
+
+            return Result::Ok;
+        }
+
+        template<OperationPolicy Policy>
+        [[nodiscard]] std::pair<Message, Result> Pop()
+        {
+            if (IsClosed())
+                return { {}, Result::Closed };
+
+            std::unique_lock lk{ m_mtx };
+            if (m_size == 0)
+            {
+                if constexpr (Policy == OperationPolicy::NonBlocking)
+                {
+                    return { {}, Result::Empty };
+                }
+                else
+                {
+                    static_assert(Policy == OperationPolicy::Blocking, "Pop: Unsupported OperationPolicy.");
+                    // use predicate to wait on conditions (UnboundedMessageQueue is closed or there is something to pop) and to avoid spurious wakeup
+                    m_popCv.wait(lk, [this] { return IsClosed() || m_size != 0; });
+
+                    if (IsClosed())
+                        return { {}, Result::Closed };
+                }
+            }
+            // ...while pop from the beginning (FIFO) [2/2]
+            std::pair<Message, Result> outcome{ std::move(*m_head->Slot(m_headIndex)), Result::Ok };
+            PopFront();
+            UpdateAboveSoftCap();
+
+            return outcome;
+        }
+
+        // set UnboundedMessageQueue state to Closed and notify all readers (if any) about it (interrupt possible waiting)
+        Result Close() noexcept
+        {
+            {
+                std::scoped_lock lk{ m_mtx };
+                m_state.store(State::Closed, std::memory_order_release);
+            }
+            m_popCv.notify_all();
+            return Result::Ok;
+        }
+
+        // lock-free backpressure signal: the depth has reached the soft cap (always false without one)
+        [[nodiscard]] bool IsAboveSoftCap() const noexcept
+        {
+            return m_aboveSoftCap.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] Stats GetStats()
+        {
+            std::scoped_lock lk{ m_mtx };
+            return { m_size, m_softCap, m_highWaterMark, m_segments, m_freeSegments, m_softCapExceeded };
+        }
+
+    private:
+        struct Segment
+        {
+            Message* Slot(std::size_t index) noexcept
+            {
+                return std::launder(reinterpret_cast<Message*>(storage + index * sizeof(Message)));
+            }
+
+            Segment* next{ nullptr };
+            // slots are constructed on push and destroyed on pop
+            alignas(Message) unsigned char storage[SegmentSize * sizeof(Message)];
+        };
+        using SegmentAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Segment>;
+        using SegmentTraits = std::allocator_traits<SegmentAllocator>;
+
+        // should be called under the lock (or from the constructor)
+        Segment* AcquireSegment()
+        {
+            Segment* segment{ nullptr };
+            if (m_free)
+            {
+                segment = std::exchange(m_free, m_free->next);
+                segment->next = nullptr;
+                --m_freeSegments;
+            }
+            else
+            {
+                segment = SegmentTraits::allocate(m_allocator, 1);
+                SegmentTraits::construct(m_allocator, segment);
+            }
+            ++m_segments;
+            return segment;
+        }
+
+        void ReleaseSegment(Segment* segment) noexcept
+        {
+            SegmentTraits::destroy(m_allocator, segment);
+            SegmentTraits::deallocate(m_allocator, segment, 1);
+        }
+
+        // should be called under the lock on a non-empty queue, destroys the head message
+        void PopFront() noexcept
+        {
+            std::destroy_at(m_head->Slot(m_headIndex));
+            ++m_headIndex;
+            --m_size;
+
+            if (m_size == 0)
+            {
+                // the only segment left is reused from its beginning
+                while (m_head != m_tail)
+                    RecycleHead();
+                m_headIndex = m_tailIndex = 0;
+            }
+            else if (m_headIndex == SegmentSize)
+            {
+                RecycleHead();
+                m_headIndex = 0;
+            }
+        }
+
+        // should be called under the lock when the head segment is drained and isn't the tail one
+        void RecycleHead() noexcept
+        {
+            auto* drained = std::exchange(m_head, m_head->next);
+            drained->next = m_free;
+            m_free = drained;
+            ++m_freeSegments;
+            --m_segments;
+        }
+
+        // should be called under the lock after every change of the queue depth
+        void UpdateAboveSoftCap() noexcept
+        {
+            m_aboveSoftCap.store(m_softCap != 0 && m_size >= m_softCap, std::memory_order_relaxed);
+        }
+
+        bool IsClosed() const noexcept
+        {
+            return m_state.load(std::memory_order_acquire) == State::Closed;
+        }
+
+    private:
+        SegmentAllocator m_allocator;
+        // to protect shared resources (segments and indexes)
+        std::mutex m_mtx;
+        // to wait on condition during blocking pop (not empty condition, there is something to pop)
+        std::condition_variable m_popCv;
+        // messages occupy [m_headIndex in m_head, m_tailIndex in m_tail), segments are linked from head to tail
+        Segment* m_head{ nullptr };
+        Segment* m_tail{ nullptr };
+        std::size_t m_headIndex{ 0 };
+        std::size_t m_tailIndex{ 0 };
+        std::size_t m_size{ 0 };
+        // drained segments waiting for reuse, linked through Segment::next
+        Segment* m_free{ nullptr };
+        // statistics, protected by the same lock
+        std::size_t m_segments{ 0 };
+        std::size_t m_freeSegments{ 0 };
+        std::size_t m_highWaterMark{ 0 };
+        std::uint64_t m_softCapExceeded{ 0 };
+        const std::size_t m_softCap;
+        std::atomic<bool> m_aboveSoftCap{ false };
+
+        enum class State { Running, Closed };
+        std::atomic<State> m_state{ State::Running };
+    };
+}
+
+#endif // UNBOUNDED_MESSAGE_QUEUE_H_
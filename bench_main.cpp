@@ -0,0 +1,257 @@
+#include "Locks.h"
+#include "MessageQueue.h"
+#include "Numa.h"
+#include "UnboundedMessageQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    enum ErrorCode {
+        Succeeded,
+        Failed
+    };
+
+    constexpr auto unhandleExceptionMsg = "Unhandled exception has been caught!\n";
+
+    template<typename... Args>
+    void Log(Args&&... args)
+    {
+        (std::cout << ... << args) << "\n";
+    }
+
+    using NumaMessageQueue = test_task::UnboundedMessageQueue<std::uint64_t, 1024, test_task::NumaAllocator<std::uint64_t>>;
+
+    template<typename Lock>
+    using LockedMessageQueue = test_task::MessageQueue<std::uint64_t, test_task::OverflowPolicy::Reject, Lock>;
+
+    // numOfPairs writers and as many readers exchange numOfMessages through a MessageQueue guarded by Lock,
+    // returns millions of messages per second
+    template<typename Lock>
+    double MeasureLock(std::uint32_t numOfPairs, std::uint64_t numOfMessages)
+    {
+        using MessageQueue = LockedMessageQueue<Lock>;
+        MessageQueue queue{ 1024 };
+        const auto share = numOfMessages / numOfPairs;
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::uint32_t i = 0; i < numOfPairs; ++i)
+        {
+            threads.emplace_back([&queue, share] {
+                for (std::uint64_t seq = 0; seq < share; ++seq)
+                    (void)queue.template Push<MessageQueue::OperationPolicy::Blocking>(seq);
+            });
+            threads.emplace_back([&queue, share] {
+                for (std::uint64_t seq = 0; seq < share; ++seq)
+                    (void)queue.template Pop<MessageQueue::OperationPolicy::Blocking>();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return static_cast<double>(share * numOfPairs) / elapsed.count() / 1e6;
+    }
+
+    // which lock wins at every thread count
+    void RunLockSweep(std::uint64_t numOfMessages)
+    {
+        Log("threads\tstd::mutex\tSpinLock\tTicketLock\tMcsLock (M msg/s)");
+        for (const std::uint32_t numOfPairs : { 1, 2, 4, 8 })
+        {
+            Log(numOfPairs * 2,
+                "\t", MeasureLock<std::mutex>(numOfPairs, numOfMessages),
+                "\t", MeasureLock<test_task::SpinLock>(numOfPairs, numOfMessages),
+                "\t", MeasureLock<test_task::TicketLock>(numOfPairs, numOfMessages),
+                "\t", MeasureLock<test_task::McsLock>(numOfPairs, numOfMessages));
+        }
+    }
+
+    struct WaitingMeasurement
+    {
+        // millions of messages per second
+        double throughput;
+        // how far apart writers finish their equal shares, relative to the whole run (zero is perfectly even)
+        double finishSpread;
+    };
+
+    // numOfPairs writers and as many readers exchange numOfMessages through a small queue, so most of the time
+    // somebody is blocked. fair waiting serves blocked writers and readers in arrival order
+    WaitingMeasurement MeasureWaiting(std::uint32_t numOfPairs, std::uint64_t numOfMessages, bool fair)
+    {
+        using MessageQueue = test_task::MessageQueue<std::uint64_t>;
+        MessageQueue queue{ 16 };
+        if (fair)
+            queue.EnableFairWaiting();
+        const auto share = numOfMessages / numOfPairs;
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::chrono::steady_clock::time_point> finished(numOfPairs);
+        std::vector<std::thread> threads;
+        for (std::uint32_t i = 0; i < numOfPairs; ++i)
+        {
+            threads.emplace_back([&queue, &finished, share, i] {
+                for (std::uint64_t seq = 0; seq < share; ++seq)
+                    (void)queue.Push<MessageQueue::OperationPolicy::Blocking>(seq);
+                finished[i] = std::chrono::steady_clock::now();
+            });
+            threads.emplace_back([&queue, share] {
+                for (std::uint64_t seq = 0; seq < share; ++seq)
+                    (void)queue.Pop<MessageQueue::OperationPolicy::Blocking>();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const auto [first, last] = std::minmax_element(finished.begin(), finished.end());
+        const std::chrono::duration<double> spread = *last - *first;
+        return { static_cast<double>(share * numOfPairs) / elapsed.count() / 1e6, spread / elapsed };
+    }
+
+    // what fair waiting costs against the default waking at every thread count
+    void RunFairness(std::uint64_t numOfMessages)
+    {
+        Log("threads\tdefault (M msg/s, finish spread)\tfair (M msg/s, finish spread)");
+        for (const std::uint32_t numOfPairs : { 1, 2, 4, 8 })
+        {
+            const auto unfair = MeasureWaiting(numOfPairs, numOfMessages, false);
+            const auto fair = MeasureWaiting(numOfPairs, numOfMessages, true);
+            Log(numOfPairs * 2, "\t", unfair.throughput, ", ", unfair.finishSpread, "\t", fair.throughput, ", ", fair.finishSpread);
+        }
+    }
+
+    // the consumer-waiting case: a message travels to an echo thread blocked in Pop and back numOfMessages times,
+    // so every push finds a parked reader to hand the message over to. prints the average round trip
+    void RunPingPong(std::uint64_t numOfMessages)
+    {
+        using MessageQueue = test_task::MessageQueue<std::uint64_t>;
+        MessageQueue ping{ 16 };
+        MessageQueue pong{ 16 };
+
+        std::thread echo{ [&ping, &pong, numOfMessages] {
+            for (std::uint64_t i = 0; i < numOfMessages; ++i)
+            {
+                const auto [msg, result] = ping.Pop<MessageQueue::OperationPolicy::Blocking>();
+                if (result != test_task::Result::Ok)
+                    return;
+                (void)pong.Push<MessageQueue::OperationPolicy::NonBlocking>(msg);
+            }
+        } };
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < numOfMessages; ++i)
+        {
+            (void)ping.Push<MessageQueue::OperationPolicy::NonBlocking>(i);
+            (void)pong.Pop<MessageQueue::OperationPolicy::Blocking>();
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        echo.join();
+
+        Log("ping-pong round trip: ", elapsed.count() / static_cast<double>(numOfMessages), " us");
+    }
+
+    // one writer and one reader exchange numOfMessages through a queue whose segments live on storageNode,
+    // returns millions of messages per second
+    double MeasurePlacement(int storageNode, int writerNode, int readerNode, std::uint64_t numOfMessages)
+    {
+        using MessageQueue = NumaMessageQueue;
+        MessageQueue queue{ 0, test_task::NumaAllocator<std::uint64_t>{ storageNode } };
+
+        std::thread reader{ [&queue, readerNode, numOfMessages] {
+            test_task::PinCurrentThreadToNode(readerNode);
+            for (std::uint64_t i = 0; i < numOfMessages; ++i)
+                if (queue.Pop<MessageQueue::OperationPolicy::Blocking>().second != test_task::Result::Ok)
+                    return;
+        } };
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            test_task::PinCurrentThreadToNode(writerNode);
+            for (std::uint64_t i = 0; i < numOfMessages; ++i)
+                (void)queue.Push<MessageQueue::OperationPolicy::NonBlocking>(i);
+        }
+        reader.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return static_cast<double>(numOfMessages) / elapsed.count() / 1e6;
+    }
+
+    // same-node and cross-node placement of the queue storage and of the reader thread against the writer one
+    void RunPlacement(std::uint64_t numOfMessages)
+    {
+        const int numOfNodes = test_task::NumaNodeCount();
+        // the writer stays on node 0, every other combination is relative to it
+        constexpr int otherNode{ 1 };
+        if (numOfNodes == 1)
+            Log("Single NUMA node: only same-node placement is measured");
+
+        struct Placement
+        {
+            const char* name;
+            int storageNode;
+            int readerNode;
+        };
+        const Placement placements[]{
+            { "same node (storage, writer, reader)", 0, 0 },
+            { "remote storage", otherNode, 0 },
+            { "remote reader", 0, otherNode },
+            { "remote storage and reader", otherNode, otherNode },
+        };
+
+        for (const auto& placement : placements)
+        {
+            const bool remote = placement.storageNode != 0 || placement.readerNode != 0;
+            if (numOfNodes == 1 && remote)
+                continue;
+            Log(placement.name, ": ", MeasurePlacement(placement.storageNode, 0, placement.readerNode, numOfMessages), " M msg/s");
+        }
+    }
+}
+
+// lock policies and fair waiting at growing thread counts, ping-pong latency, NUMA placement of the queue storage and threads.
+// usage: MessageQueueBench [all|locks|fair|pingpong|numa] [numOfMessages]
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const std::string mode = argc > 1 ? argv[1] : "all";
+        const std::uint64_t numOfMessages = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+        if (mode != "all" && mode != "locks" && mode != "fair" && mode != "pingpong" && mode != "numa")
+        {
+            Log("Unknown mode: ", mode);
+            return Failed;
+        }
+
+        if (mode == "all" || mode == "locks")
+            RunLockSweep(numOfMessages);
+        if (mode == "all" || mode == "fair")
+            RunFairness(numOfMessages);
+        if (mode == "all" || mode == "pingpong")
+            RunPingPong(numOfMessages);
+        // pins the main thread, so it goes last
+        if (mode == "all" || mode == "numa")
+            RunPlacement(numOfMessages);
+    }
+    catch (const std::exception& exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return Failed;
+    }
+    catch (...)
+    {
+        std::cerr << unhandleExceptionMsg;
+        return Failed;
+    }
+
+    return Succeeded;
+}
@@ -1,8 +1,13 @@
 #include "MessageQueue.h"
 
+#if defined(__linux__)
+#include "Numa.h"
+#endif
+
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <type_traits>
@@ -59,12 +64,30 @@ namespace
         // just emulate some logic
         return context % 2;
     }
+
+    // keeps the calling reader/writer on the CPUs of the node, so all of them share the queue's cache lines.
+    // a negative node leaves the thread to the scheduler, pinning is supported on Linux only
+    void PinToNode(int node)
+    {
+        if (node < 0)
+            return;
+#if defined(__linux__)
+        test_task::PinCurrentThreadToNode(node);
+#else
+        throw std::invalid_argument{ "Pinning to a NUMA node is supported on Linux only." };
+#endif
+    }
 }
 
-int main()
+// usage: MessageQueueDemo [node], readers and writers are pinned to the CPUs of the NUMA node if it is provided
+int main(int argc, char* argv[])
 {
     try
     {
+        const int node = argc > 1 ? std::stoi(argv[1]) : -1;
+        // an invalid node is reported before any reader/writer is started
+        PinToNode(node);
+
         Context context;
 
         constexpr std::size_t numOfReaders{ 3 };
@@ -72,10 +95,11 @@ int main()
         readers.reserve(numOfReaders);
         for (std::size_t i = 0; i < numOfReaders; ++i)
         {
-            readers.emplace_back([i, &context]
+            readers.emplace_back([i, node, &context]
             {
                 try
                 {
+                    PinToNode(node);
                     const auto id = "Reader " + std::to_string(i);
                     while (!context.stop.load(std::memory_order_relaxed))
                     {
@@ -119,10 +143,11 @@ int main()
         writers.reserve(numOfWriters);
         for (std::size_t i = 0; i < numOfWriters; ++i)
         {
-            writers.emplace_back([i, &context]
+            writers.emplace_back([i, node, &context]
             {
                 try
                 {
+                    PinToNode(node);
                     const auto iStr = std::to_string(i);
                     const auto id = "Writer " + iStr;
                     while (!context.stop.load(std::memory_order_relaxed))
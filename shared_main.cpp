@@ -0,0 +1,174 @@
+#include "SharedMessageQueue.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    enum ErrorCode {
+        Succeeded,
+        Failed
+    };
+
+    constexpr auto unhandleExceptionMsg = "Unhandled exception has been caught!\n";
+
+    template<typename... Args>
+    void Log(Args&&... args)
+    {
+        (std::cout << ... << args) << "\n";
+    }
+
+    struct Message
+    {
+        std::uint32_t producerId;
+        std::uint64_t seq;
+    };
+
+    using MessageQueue = test_task::SharedMessageQueue<Message>;
+
+    constexpr std::uint32_t numOfWriters{ 3 };
+    constexpr std::uint64_t numOfMessages{ 100000 };
+
+    int RunWriter(const std::string& name, std::uint32_t producerId)
+    {
+        MessageQueue queue{ name };
+        for (std::uint64_t seq = 0; seq < numOfMessages; ++seq)
+            if (queue.Push<MessageQueue::OperationPolicy::Blocking>(Message{ producerId, seq }) != test_task::Result::Ok)
+                return Failed;
+
+        return Succeeded;
+    }
+
+    // every message should be received exactly once and in FIFO order per writer
+    int RunReader(const std::string& name)
+    {
+        MessageQueue queue{ name };
+        std::vector<std::uint64_t> expected(numOfWriters, 0);
+        for (std::uint64_t received = 0; received < numOfWriters * numOfMessages; ++received)
+        {
+            const auto [msg, result] = queue.Pop<MessageQueue::OperationPolicy::Blocking>();
+            if (result != test_task::Result::Ok || msg.producerId >= numOfWriters || msg.seq != expected[msg.producerId]++)
+            {
+                Log("Reader: unexpected message. Code: ", static_cast<int>(result), ", producer: ", msg.producerId, ", seq: ", msg.seq);
+                return Failed;
+            }
+        }
+
+        return Succeeded;
+    }
+
+    template<typename Function>
+    pid_t Spawn(Function&& function)
+    {
+        const pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            int code = Failed;
+            try
+            {
+                code = function();
+            }
+            catch (const std::exception& exc)
+            {
+                std::cerr << exc.what();
+            }
+            catch (...)
+            {
+                std::cerr << unhandleExceptionMsg;
+            }
+            // skip parent's atexit handlers and static destructors
+            ::_exit(code);
+        }
+        return pid;
+    }
+
+    bool Succeed(pid_t pid)
+    {
+        int status = 0;
+        return pid > 0 && ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == Succeeded;
+    }
+
+    template<typename Queue>
+    bool AttachFails(const std::string& name)
+    {
+        try
+        {
+            Queue queue{ name };
+        }
+        catch (const std::runtime_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    // a region of another Message type or a truncated one is rejected on attach instead of being accessed out of bounds
+    bool CheckAttachValidation(const std::string& name)
+    {
+        MessageQueue queue{ name, 4 };
+        bool succeeded = AttachFails<test_task::SharedMessageQueue<std::uint64_t>>(name);
+
+        const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        struct stat st {};
+        succeeded = succeeded && fd >= 0 && ::fstat(fd, &st) == 0 && ::ftruncate(fd, st.st_size - 1) == 0;
+        if (fd >= 0)
+            ::close(fd);
+        succeeded = succeeded && AttachFails<MessageQueue>(name);
+
+        if (!succeeded)
+            Log("Attach validation failed");
+        return succeeded;
+    }
+}
+
+int main()
+{
+    try
+    {
+        const auto name = "/test_task_mq_" + std::to_string(::getpid());
+        MessageQueue queue{ name, 64 };
+
+        const pid_t reader = Spawn([&name] { return RunReader(name); });
+        std::vector<pid_t> writers;
+        for (std::uint32_t i = 0; i < numOfWriters; ++i)
+            writers.push_back(Spawn([&name, i] { return RunWriter(name, i); }));
+
+        bool succeeded = CheckAttachValidation(name + "_attach");
+        for (const auto writer : writers)
+            succeeded = Succeed(writer) && succeeded;
+        succeeded = Succeed(reader) && succeeded;
+
+        // Close is visible across processes and makes further push/pop impossible
+        queue.Close();
+        succeeded = succeeded && queue.Push<MessageQueue::OperationPolicy::NonBlocking>() == test_task::Result::Closed;
+        succeeded = succeeded && queue.Pop<MessageQueue::OperationPolicy::Blocking>().second == test_task::Result::Closed;
+
+        if (!succeeded)
+        {
+            Log("Interprocess exchange failed");
+            return Failed;
+        }
+
+        Log("The program is finished successfully");
+    }
+    catch (const std::exception& exc)
+    {
+        std::cerr << exc.what();
+        return Failed;
+    }
+    catch (...)
+    {
+        std::cerr << unhandleExceptionMsg;
+        return Failed;
+    }
+
+    return Succeeded;
+}
@@ -0,0 +1,225 @@
+#include "MessageQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    enum ErrorCode {
+        Succeeded,
+        Failed
+    };
+
+    constexpr auto unhandleExceptionMsg = "Unhandled exception has been caught!\n";
+
+    template<typename... Args>
+    void Log(Args&&... args)
+    {
+        (std::cout << ... << args) << "\n";
+    }
+
+    struct Message
+    {
+        std::uint32_t producerId;
+        std::uint64_t seq;
+    };
+
+    using MessageQueue = test_task::MessageQueue<Message>;
+
+    struct Options
+    {
+        std::uint64_t numOfMessages{ 1000000 };
+        std::uint32_t numOfWriters{ 4 };
+        std::uint32_t numOfReaders{ 4 };
+        std::size_t queueSize{ 64 };
+    };
+
+    // one bit per (producer, seq): a message popped twice is detected exactly (a lost one breaks the pushed/popped balance)
+    class Ledger final
+    {
+    public:
+        Ledger(std::uint32_t numOfWriters, std::uint64_t numOfMessages)
+            : m_numOfMessages{ numOfMessages }
+            , m_bits(numOfWriters * ((numOfMessages + 63) / 64))
+        {
+        }
+
+        // returns false if the message has been seen already
+        bool Mark(const Message& msg) noexcept
+        {
+            const auto index = msg.producerId * ((m_numOfMessages + 63) / 64) + msg.seq / 64;
+            const auto bit = std::uint64_t{ 1 } << (msg.seq % 64);
+            return (m_bits[index].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+        }
+
+    private:
+        const std::uint64_t m_numOfMessages;
+        std::vector<std::atomic<std::uint64_t>> m_bits;
+    };
+
+    struct Counters
+    {
+        std::atomic<std::uint64_t> pushed{ 0 };
+        std::atomic<std::uint64_t> popped{ 0 };
+        std::atomic<std::uint64_t> errors{ 0 };
+    };
+
+    // writers alternate blocking and non-blocking (retried on Full) pushes, so both paths race with each other
+    void RunWriter(MessageQueue& queue, Counters& counters, std::uint32_t producerId, std::uint64_t numOfMessages)
+    {
+        for (std::uint64_t seq = 0; seq < numOfMessages; ++seq)
+        {
+            auto result = test_task::Result::Full;
+            if (seq % 2 == 0)
+            {
+                result = queue.Push<MessageQueue::OperationPolicy::Blocking>(Message{ producerId, seq });
+            }
+            else
+            {
+                while ((result = queue.Push<MessageQueue::OperationPolicy::NonBlocking>(Message{ producerId, seq })) == test_task::Result::Full)
+                    std::this_thread::yield();
+            }
+
+            if (result == test_task::Result::Closed)
+                return;
+            if (result != test_task::Result::Ok)
+            {
+                ++counters.errors;
+                return;
+            }
+            counters.pushed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // every reader sees the messages of a producer in increasing seq order, and no message is seen twice
+    void RunReader(MessageQueue& queue, Counters& counters, Ledger& ledger, std::uint32_t numOfWriters, std::uint32_t readerId)
+    {
+        std::vector<std::int64_t> lastSeq(numOfWriters, -1);
+        for (std::uint64_t i = 0;; ++i)
+        {
+            const auto [msg, result] = (i + readerId) % 4 == 0
+                ? queue.Pop<MessageQueue::OperationPolicy::NonBlocking>()
+                : queue.Pop<MessageQueue::OperationPolicy::Blocking>();
+            if (result == test_task::Result::Closed)
+                return;
+            if (result == test_task::Result::Empty)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (result != test_task::Result::Ok || msg.producerId >= numOfWriters || static_cast<std::int64_t>(msg.seq) <= lastSeq[msg.producerId] || !ledger.Mark(msg))
+            {
+                Log("Reader ", readerId, ": unexpected message. Code: ", static_cast<int>(result), ", producer: ", msg.producerId, ", seq: ", msg.seq);
+                ++counters.errors;
+                return;
+            }
+            lastSeq[msg.producerId] = static_cast<std::int64_t>(msg.seq);
+            counters.popped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // closeAfter == 0: readers drain everything, then the queue is closed. otherwise it is closed while
+    // writers and readers are still running: Ok pushes should be either popped or left in the queue
+    bool RunRound(const Options& options, std::uint64_t closeAfter, bool fair)
+    {
+        MessageQueue queue{ options.queueSize };
+        if (fair)
+            queue.EnableFairWaiting();
+        Counters counters;
+        Ledger ledger{ options.numOfWriters, options.numOfMessages };
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::uint32_t i = 0; i < options.numOfReaders; ++i)
+            threads.emplace_back([&, i] { RunReader(queue, counters, ledger, options.numOfWriters, i); });
+        for (std::uint32_t i = 0; i < options.numOfWriters; ++i)
+            threads.emplace_back([&, i] { RunWriter(queue, counters, i, options.numOfMessages); });
+
+        const auto total = options.numOfWriters * options.numOfMessages;
+        const auto target = closeAfter == 0 ? total : closeAfter;
+        while (counters.popped.load(std::memory_order_relaxed) < target && counters.errors.load(std::memory_order_relaxed) == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        queue.Close();
+
+        // Close should interrupt every blocked writer and reader
+        for (auto& thread : threads)
+            thread.join();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const auto pushed = counters.pushed.load();
+        const auto popped = counters.popped.load();
+        const auto left = queue.GetStats().size;
+        bool succeeded = counters.errors == 0 && pushed == popped + left;
+        succeeded = succeeded && (closeAfter != 0 || (pushed == total && popped == total));
+        // nothing gets in or out after Close
+        succeeded = succeeded && queue.Push<MessageQueue::OperationPolicy::NonBlocking>(Message{ 0, 0 }) == test_task::Result::Closed;
+        succeeded = succeeded && queue.Pop<MessageQueue::OperationPolicy::NonBlocking>().second == test_task::Result::Closed;
+
+        Log(fair ? "fair " : "", closeAfter == 0 ? "drain" : "close race", ": pushed ", pushed, ", popped ", popped, ", left ", left,
+            ", ", static_cast<double>(pushed + popped) / elapsed.count() / 1e6, " M ops/s", succeeded ? "" : " FAILED");
+        return succeeded;
+    }
+}
+
+// many writers tag messages with (producerId, seq), many readers check that nothing is lost or duplicated and
+// that per-producer FIFO order holds, then the same is repeated with Close racing the traffic (with and without fair waiting).
+// usage: MessageQueueStress [numOfMessagesPerWriter] [numOfWriters] [numOfReaders] [queueSize]
+int main(int argc, char* argv[])
+{
+    try
+    {
+        Options options;
+        if (argc > 1)
+            options.numOfMessages = std::strtoull(argv[1], nullptr, 10);
+        if (argc > 2)
+            options.numOfWriters = static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10));
+        if (argc > 3)
+            options.numOfReaders = static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10));
+        if (argc > 4)
+            options.queueSize = std::strtoull(argv[4], nullptr, 10);
+        if (options.numOfMessages == 0 || options.numOfWriters == 0 || options.numOfReaders == 0)
+        {
+            Log("Invalid arguments: every number should be greater than zero");
+            return Failed;
+        }
+
+        const auto total = options.numOfWriters * options.numOfMessages;
+        bool succeeded = true;
+        // the default waking and the fair waiting lines
+        for (const bool fair : { false, true })
+        {
+            succeeded = RunRound(options, 0, fair) && succeeded;
+            // close early, half-way and right before the end
+            for (const auto closeAfter : { std::uint64_t{ 1 }, total / 2, total - 1 })
+                succeeded = RunRound(options, std::max<std::uint64_t>(closeAfter, 1), fair) && succeeded;
+        }
+
+        if (!succeeded)
+        {
+            Log("Stress test failed");
+            return Failed;
+        }
+
+        Log("The program is finished successfully");
+    }
+    catch (const std::exception& exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return Failed;
+    }
+    catch (...)
+    {
+        std::cerr << unhandleExceptionMsg;
+        return Failed;
+    }
+
+    return Succeeded;
+}
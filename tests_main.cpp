@@ -0,0 +1,1056 @@
+#include "BatchingProducer.h"
+#include "BroadcastQueue.h"
+#include "CapacityAutotuner.h"
+#include "ConflatingMessageQueue.h"
+#include "FixedMessageQueue.h"
+#include "MessageQueue.h"
+#include "RetainedLog.h"
+#include "RingPipeline.h"
+#include "TraceReplay.h"
+#include "UnboundedMessageQueue.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    enum ErrorCode {
+        Succeeded,
+        Failed
+    };
+
+    constexpr auto unhandleExceptionMsg = "Unhandled exception has been caught!\n";
+
+    template<typename... Args>
+    void Log(Args&&... args)
+    {
+        (std::cout << ... << args) << "\n";
+    }
+
+    // collects broken expectations of a single check, every one of them is logged
+    class Expectations final
+    {
+    public:
+        explicit Expectations(const char* check)
+            : m_check{ check }
+        {
+        }
+
+        void operator()(bool condition, const char* what)
+        {
+            if (condition)
+                return;
+
+            Log(m_check, ": unexpected ", what);
+            m_succeeded = false;
+        }
+
+        [[nodiscard]] bool Succeeded() const noexcept
+        {
+            return m_succeeded;
+        }
+
+    private:
+        const char* m_check;
+        bool m_succeeded{ true };
+    };
+
+    using MessageQueue = test_task::MessageQueue<std::string>;
+    using OperationPolicy = MessageQueue::OperationPolicy;
+
+    bool IsSignaled(int fd)
+    {
+        pollfd pfd{ fd, POLLIN, 0 };
+        return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+    }
+
+    // the readable descriptor follows "there is something to pop", the writable one "there is free space to push into",
+    // both are signaled once the queue is closed
+    bool CheckReadinessFds()
+    {
+        Expectations expect{ "readiness fds" };
+        MessageQueue queue{ 2 };
+        expect(queue.ReadableFd() == -1 && queue.WritableFd() == -1, "descriptors before EnableReadinessFds");
+
+        queue.EnableReadinessFds();
+        const auto readable = queue.ReadableFd();
+        const auto writable = queue.WritableFd();
+        expect(!IsSignaled(readable) && IsSignaled(writable), "state of an empty queue");
+
+        (void)queue.Push<OperationPolicy::NonBlocking>("first");
+        expect(IsSignaled(readable) && IsSignaled(writable), "state of a partially filled queue");
+
+        (void)queue.Push<OperationPolicy::NonBlocking>("second");
+        expect(IsSignaled(readable) && !IsSignaled(writable), "state of a full queue");
+
+        (void)queue.Pop<OperationPolicy::NonBlocking>();
+        (void)queue.Get([](const std::string&) { return true; });
+        expect(!IsSignaled(readable) && IsSignaled(writable), "state of a drained queue");
+
+        queue.Close();
+        expect(IsSignaled(readable) && IsSignaled(writable), "state of a closed queue");
+        expect(queue.Pop<OperationPolicy::NonBlocking>().second == test_task::Result::Closed, "Pop result after Close");
+        return expect.Succeeded();
+    }
+
+    test_task::MessageCodec<std::string> StringCodec()
+    {
+        return { [](const std::string& msg, std::string& buffer) { buffer += msg; }, [](std::string_view bytes) { return std::string{ bytes }; } };
+    }
+
+    // pops everything available without waiting
+    std::vector<std::string> Drain(MessageQueue& queue)
+    {
+        std::vector<std::string> messages;
+        for (auto outcome = queue.Pop<OperationPolicy::NonBlocking>(); outcome.second == test_task::Result::Ok; outcome = queue.Pop<OperationPolicy::NonBlocking>())
+            messages.push_back(std::move(outcome.first));
+        return messages;
+    }
+
+    // messages pushed and not extracted (by Pop or Get) before a restart are recovered in FIFO order,
+    // a second EnableJournal is rejected without touching the active log
+    bool CheckJournalRecovery()
+    {
+        Expectations expect{ "journal recovery" };
+        const auto path = (std::filesystem::temp_directory_path() / ("MessageQueueTests." + std::to_string(::getpid()) + ".journal")).string();
+        std::remove(path.c_str());
+
+        {
+            MessageQueue queue{ 8 };
+            queue.EnableJournal(StringCodec(), path);
+            for (const auto* msg : { "a", "b", "c", "d" })
+                (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+            expect(queue.Pop<OperationPolicy::NonBlocking>().first == "a", "Pop before the restart");
+            expect(queue.Get([](const std::string& msg) { return msg == "c"; }).first == "c", "Get before the restart");
+
+            bool rejected{ false };
+            try
+            {
+                queue.EnableJournal(StringCodec(), path);
+            }
+            catch (const std::logic_error&)
+            {
+                rejected = true;
+            }
+            expect(rejected, "second EnableJournal accepted");
+            // must reach the same log as the messages before
+            (void)queue.Push<OperationPolicy::NonBlocking>("e");
+        }
+
+        {
+            MessageQueue queue{ 8 };
+            queue.EnableJournal(StringCodec(), path);
+            expect(Drain(queue) == std::vector<std::string>{ "b", "d", "e" }, "messages recovered after the first restart");
+        }
+
+        {
+            MessageQueue queue{ 8 };
+            queue.EnableJournal(StringCodec(), path);
+            expect(queue.GetStats().size == 0, "messages recovered after a drained run");
+        }
+
+        std::remove(path.c_str());
+        return expect.Succeeded();
+    }
+
+    // messages handed over straight to a waiting reader don't keep the log growing: it is compacted like a drained queue
+    bool CheckJournalCompaction()
+    {
+        Expectations expect{ "journal compaction" };
+        const auto path = (std::filesystem::temp_directory_path() / ("MessageQueueTests." + std::to_string(::getpid()) + ".compaction.journal")).string();
+        std::remove(path.c_str());
+        {
+            constexpr std::size_t numOfMessages{ 2000 };
+            test_task::JournalOptions options;
+            options.compactThreshold = 4096;
+            MessageQueue queue{ 8 };
+            queue.EnableJournal(StringCodec(), path, options);
+            std::thread reader{ [&queue] {
+                for (std::size_t i = 0; i < numOfMessages; ++i)
+                    (void)queue.Pop<OperationPolicy::Blocking>();
+            } };
+            for (std::size_t i = 0; i < numOfMessages; ++i)
+            {
+                (void)queue.Push<OperationPolicy::Blocking>("message");
+                std::this_thread::yield();
+            }
+            reader.join();
+            expect(std::filesystem::file_size(path) < 2 * options.compactThreshold, "journal size after a drained run");
+        }
+        std::remove(path.c_str());
+        return expect.Succeeded();
+    }
+
+    // a blocked group writer that still doesn't fit mustn't swallow the wakeup meant for a single writer behind it
+    bool CheckGroupWriterWakeups()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "group writer wakeups" };
+        MessageQueue queue{ 2 };
+        (void)queue.Push<OperationPolicy::NonBlocking>("first");
+        (void)queue.Push<OperationPolicy::NonBlocking>("second");
+
+        std::atomic<bool> singlePushed{ false };
+        std::thread groupWriter{ [&queue] { (void)queue.PushGroup<OperationPolicy::Blocking>(std::vector<std::string>{ "group", "group" }); } };
+        std::this_thread::sleep_for(20ms);
+        std::thread singleWriter{ [&queue, &singlePushed] {
+            singlePushed = queue.Push<OperationPolicy::Blocking>("single") == test_task::Result::Ok;
+        } };
+        std::this_thread::sleep_for(20ms);
+
+        // one free slot: the group still doesn't fit, the single message does
+        (void)queue.Pop<OperationPolicy::Blocking>();
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (!singlePushed && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        expect(singlePushed, "single writer blocked while a slot is free");
+
+        queue.Close();
+        groupWriter.join();
+        singleWriter.join();
+        return expect.Succeeded();
+    }
+
+    // converts to a message by throwing, to fail a Push while it builds the message
+    struct ThrowingSource
+    {
+        operator std::string() const
+        {
+            throw std::runtime_error{ "message construction failed" };
+        }
+    };
+
+    // a Push failing while it hands a message over to a parked reader leaves the reader in line, so Close still releases it
+    bool CheckFailedHandOff()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "failed hand-off" };
+        // shared with the reader: a reader that is never released keeps it alive
+        const auto queuePtr = std::make_shared<MessageQueue>(2);
+        auto& queue = *queuePtr;
+        const auto released = std::make_shared<std::atomic<bool>>(false);
+        std::thread reader{ [queuePtr, released] {
+            *released = queuePtr->Pop<OperationPolicy::Blocking>().second == test_task::Result::Closed;
+        } };
+        std::this_thread::sleep_for(20ms);
+
+        bool thrown{ false };
+        try
+        {
+            (void)queue.Push<OperationPolicy::NonBlocking>(ThrowingSource{});
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        expect(thrown, "Push result with a throwing constructor");
+
+        queue.Close();
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (!*released && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        expect(*released, "reader blocked after Close");
+        if (*released)
+            reader.join();
+        else
+            reader.detach();
+        return expect.Succeeded();
+    }
+
+    // its moves fail on demand, e.g. while a blocked Pop promotes a delayed message
+    struct Fragile
+    {
+        Fragile() = default;
+
+        explicit Fragile(int messageValue)
+            : value{ messageValue }
+        {
+        }
+
+        Fragile(const Fragile&) = default;
+        Fragile& operator=(const Fragile&) = default;
+
+        Fragile(Fragile&& other)
+            : value{ other.value }
+        {
+            if (failMoves)
+                throw std::runtime_error{ "message move failed" };
+        }
+
+        Fragile& operator=(Fragile&& other)
+        {
+            if (failMoves)
+                throw std::runtime_error{ "message move failed" };
+            value = other.value;
+            return *this;
+        }
+
+        static inline std::atomic<bool> failMoves{ false };
+        int value{ 0 };
+    };
+
+    // a blocked Pop failing while it waits leaves the line, so the readers after it are served
+    bool CheckFailedWait()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "failed wait" };
+        using FragileQueue = test_task::MessageQueue<Fragile>;
+        using FragilePolicy = FragileQueue::OperationPolicy;
+        // shared with the reader: a reader that is never served keeps it alive
+        const auto queuePtr = std::make_shared<FragileQueue>(2);
+        auto& queue = *queuePtr;
+        (void)queue.PushDelayed(std::chrono::steady_clock::now() + 20ms, 1);
+
+        Fragile::failMoves = true;
+        bool thrown{ false };
+        try
+        {
+            // the delayed message is promoted by the waiting Pop
+            (void)queue.Pop<FragilePolicy::Blocking>();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        Fragile::failMoves = false;
+        expect(thrown, "Pop result with a failing promotion");
+
+        const auto [msg, result] = queue.Pop<FragilePolicy::NonBlocking>();
+        expect(result == test_task::Result::Ok && msg.value == 1, "Pop of the delayed message after the failed wait");
+
+        // the next blocked reader is the first in line now
+        const auto received = std::make_shared<std::atomic<int>>(0);
+        std::thread reader{ [queuePtr, received] { *received = queuePtr->Pop<FragilePolicy::Blocking>().first.value; } };
+        std::this_thread::sleep_for(20ms);
+        (void)queue.Push<FragilePolicy::NonBlocking>(2);
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (*received == 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(1ms);
+        expect(*received == 2, "message received by a reader after the failed wait");
+        if (*received == 2)
+            reader.join();
+        else
+            reader.detach();
+        return expect.Succeeded();
+    }
+
+    // crossings queued by concurrent operations are all delivered by the time they return, the last one matches the final depth
+    bool CheckWatermarkDelivery()
+    {
+        Expectations expect{ "watermark delivery" };
+        MessageQueue queue{ 8 };
+        std::size_t delivered{ 0 };
+        MessageQueue::Watermark last{ MessageQueue::Watermark::Low };
+        // callbacks are never run concurrently
+        queue.SetWatermarks(1, 0, [&delivered, &last](MessageQueue::Watermark watermark, std::size_t) {
+            ++delivered;
+            last = watermark;
+        });
+
+        constexpr std::size_t threadsCount{ 4 };
+        constexpr std::size_t iterations{ 2000 };
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < threadsCount; ++i)
+        {
+            threads.emplace_back([&queue] {
+                for (std::size_t j = 0; j < iterations; ++j)
+                {
+                    (void)queue.Push<OperationPolicy::Blocking>("message");
+                    (void)queue.Pop<OperationPolicy::Blocking>();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        expect(delivered != 0 && delivered % 2 == 0, "number of delivered crossings");
+        expect(last == MessageQueue::Watermark::Low, "last delivered crossing");
+        return expect.Succeeded();
+    }
+
+    // messages beyond the queue size go to the spill and come back in FIFO order, a segment that can't be created
+    // is reported by the Push without breaking the queue
+    bool CheckSpill()
+    {
+        Expectations expect{ "spill" };
+        {
+            MessageQueue queue{ 2 };
+            queue.EnableSpill(StringCodec(), std::filesystem::temp_directory_path().string(), 64);
+            for (const auto* msg : { "a", "b", "c", "d", "e" })
+                expect(queue.Push<OperationPolicy::NonBlocking>(msg) == test_task::Result::Ok, "Push result with the spill");
+            expect(queue.SpilledCount() == 3, "number of spilled messages");
+            expect(Drain(queue) == std::vector<std::string>{ "a", "b", "c", "d", "e" }, "order of spilled messages");
+        }
+
+        {
+            MessageQueue queue{ 1 };
+            queue.EnableSpill(StringCodec(), "/nonexistent/MessageQueueTests", 64);
+            (void)queue.Push<OperationPolicy::NonBlocking>("a");
+            bool thrown{ false };
+            try
+            {
+                (void)queue.Push<OperationPolicy::NonBlocking>("b");
+            }
+            catch (const std::system_error&)
+            {
+                thrown = true;
+            }
+            expect(thrown, "Push result without a segment");
+            expect(queue.SpilledCount() == 0 && Drain(queue) == std::vector<std::string>{ "a" }, "queue state after a failed spill");
+        }
+        return expect.Succeeded();
+    }
+
+    // every message dropped by DropOldest reaches the eviction handler in FIFO order, including the excess left by a shrink
+    bool CheckEvictions()
+    {
+        Expectations expect{ "evictions" };
+        using DroppingQueue = test_task::MessageQueue<std::string, test_task::OverflowPolicy::DropOldest>;
+        DroppingQueue queue{ 4 };
+        std::vector<std::string> evicted;
+        queue.SetEvictionHandler([&evicted](std::string&& msg) { evicted.push_back(std::move(msg)); });
+
+        for (const auto* msg : { "a", "b", "c", "d", "e" })
+            (void)queue.Push<DroppingQueue::OperationPolicy::NonBlocking>(msg);
+        expect(evicted == std::vector<std::string>{ "a" }, "messages evicted from a full queue");
+
+        queue.Resize(2);
+        (void)queue.Push<DroppingQueue::OperationPolicy::NonBlocking>("f");
+        expect(evicted == std::vector<std::string>{ "a", "b", "c", "d" }, "messages evicted after a shrink");
+        expect(queue.GetStats().evicted == 4, "evicted counter");
+        return expect.Succeeded();
+    }
+
+    // a blocked writer takes the slot freed by expiration of a message behind a head without TTL
+    bool CheckExpirationBehindHead()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "expiration behind the head" };
+        for (const bool fair : { false, true })
+        {
+            MessageQueue queue{ 2 };
+            if (fair)
+                queue.EnableFairWaiting();
+            (void)queue.Push<OperationPolicy::NonBlocking>("head");
+            (void)queue.PushUntil<OperationPolicy::NonBlocking>(std::chrono::steady_clock::now() + 50ms, "short-lived");
+
+            std::atomic<bool> pushed{ false };
+            std::thread writer{ [&queue, &pushed] { pushed = queue.Push<OperationPolicy::Blocking>("tail") == test_task::Result::Ok; } };
+            const auto deadline = std::chrono::steady_clock::now() + 2s;
+            while (!pushed && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(1ms);
+            expect(pushed, fair ? "fair writer blocked after the expiration" : "writer blocked after the expiration");
+
+            queue.Close();
+            writer.join();
+        }
+        return expect.Succeeded();
+    }
+
+    // GetAll and RemoveIf extract matching messages in FIFO order and return their number, the freed slots release
+    // as many blocked writers, and the removal positions they log let the journal recover the rest after a restart
+    bool CheckGetAllAndRemoveIf()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "GetAll and RemoveIf" };
+        const auto isEven = [](const std::string& msg) { return (msg.back() - '0') % 2 == 0; };
+        {
+            MessageQueue queue{ 8 };
+            for (const auto* msg : { "0", "1", "2", "3", "4", "5" })
+                (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+            std::vector<std::string> extracted;
+            expect(queue.GetAll(isEven, std::back_inserter(extracted)) == 3, "GetAll count");
+            expect(extracted == std::vector<std::string>{ "0", "2", "4" }, "messages extracted by GetAll");
+            expect(queue.RemoveIf([](const std::string& msg) { return msg == "3"; }) == 1, "RemoveIf count");
+            expect(queue.RemoveIf(isEven) == 0, "RemoveIf count without a match");
+            expect(Drain(queue) == std::vector<std::string>{ "1", "5" }, "messages left by GetAll and RemoveIf");
+        }
+
+        {
+            MessageQueue queue{ 3 };
+            for (const auto* msg : { "0", "1", "2" })
+                (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+            std::atomic<int> pushed{ 0 };
+            std::vector<std::thread> writers;
+            for (const auto* msg : { "3", "4", "5" })
+                writers.emplace_back([&queue, &pushed, msg] {
+                    if (queue.Push<OperationPolicy::Blocking>(msg) == test_task::Result::Ok)
+                        ++pushed;
+                });
+            std::this_thread::sleep_for(20ms);
+            expect(queue.RemoveIf([](const std::string&) { return true; }) == 3, "RemoveIf count of a full queue");
+            const auto deadline = std::chrono::steady_clock::now() + 2s;
+            while (pushed != 3 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(1ms);
+            expect(pushed == 3, "writers blocked after RemoveIf");
+            queue.Close();
+            for (auto& writer : writers)
+                writer.join();
+        }
+
+        {
+            const auto path = (std::filesystem::temp_directory_path() / ("MessageQueueTests." + std::to_string(::getpid()) + ".extract.journal")).string();
+            std::remove(path.c_str());
+            {
+                MessageQueue queue{ 8 };
+                queue.EnableJournal(StringCodec(), path);
+                for (const auto* msg : { "a0", "a1", "a2", "a3" })
+                    (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+                (void)queue.PushUntil<OperationPolicy::NonBlocking>(std::chrono::steady_clock::now() + 10ms, "x5");
+                for (const auto* msg : { "a6", "a7" })
+                    (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+                std::this_thread::sleep_for(20ms);
+                // removals behind each other in one pass: every logged position accounts for the ones removed before it
+                std::vector<std::string> extracted;
+                expect(queue.GetAll([](const std::string& msg) { return msg == "a1" || msg == "a3" || msg == "a6"; }, std::back_inserter(extracted)) == 3,
+                    "GetAll count with the journal");
+                expect(queue.RemoveIf([](const std::string& msg) { return msg == "a7"; }) == 1, "RemoveIf count with the journal");
+            }
+
+            MessageQueue queue{ 8 };
+            queue.EnableJournal(StringCodec(), path);
+            expect(Drain(queue) == std::vector<std::string>{ "a0", "a2" }, "messages recovered after GetAll and RemoveIf");
+            std::remove(path.c_str());
+        }
+        return expect.Succeeded();
+    }
+
+    // Peek returns the head without removing it, VisitSnapshot visits the queued messages in FIFO order without the lock,
+    // both skip expired messages
+    bool CheckPeekAndSnapshot()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "peek and snapshot" };
+        // shared with the writer: a writer stuck behind the lock keeps it alive
+        const auto queuePtr = std::make_shared<MessageQueue>(8);
+        auto& queue = *queuePtr;
+        expect(queue.Peek().second == test_task::Result::Empty, "Peek of an empty queue");
+
+        (void)queue.PushUntil<OperationPolicy::NonBlocking>(std::chrono::steady_clock::now() + 10ms, "short-lived");
+        for (const auto* msg : { "a", "b" })
+            (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+        (void)queue.PushUntil<OperationPolicy::NonBlocking>(std::chrono::steady_clock::now() + 10ms, "short-lived");
+        (void)queue.Push<OperationPolicy::NonBlocking>("c");
+        std::this_thread::sleep_for(20ms);
+
+        const auto head = queue.Peek();
+        expect(head.first == "a" && head.second == test_task::Result::Ok, "Peek behind an expired head");
+        expect(queue.Peek().first == "a", "Peek repeated");
+
+        std::vector<std::string> visited;
+        const auto pushed = std::make_shared<std::atomic<bool>>(false);
+        const auto count = queue.VisitSnapshot([&queuePtr, &visited, &pushed](const std::string& msg) {
+            visited.push_back(msg);
+            if (visited.size() != 1)
+                return;
+            // a writer gets through while the visitor runs
+            std::thread writer{ [queuePtr, pushed] { *pushed = queuePtr->Push<OperationPolicy::NonBlocking>("d") == test_task::Result::Ok; } };
+            const auto deadline = std::chrono::steady_clock::now() + 2s;
+            while (!*pushed && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(1ms);
+            if (*pushed)
+                writer.join();
+            else
+                writer.detach();
+        });
+        expect(count == 3 && visited == std::vector<std::string>{ "a", "b", "c" }, "messages visited in FIFO order");
+        expect(*pushed, "Push while the visitor runs");
+        expect(Drain(queue) == std::vector<std::string>{ "a", "b", "c", "d" }, "messages left by Peek and VisitSnapshot");
+
+        queue.Close();
+        expect(queue.Peek().second == test_task::Result::Closed, "Peek result after Close");
+        return expect.Succeeded();
+    }
+
+    // a delayed message gets the default TTL counted from its visibility even when it is spilled, a due one makes
+    // the readable descriptor fire, delayed messages are rejected while the journal is enabled
+    bool CheckDelayedMessages()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "delayed messages" };
+        {
+            MessageQueue queue{ 1 };
+            queue.EnableSpill(StringCodec(), std::filesystem::temp_directory_path().string(), 64);
+            queue.SetDefaultTtl(30ms);
+            (void)queue.Push<OperationPolicy::NonBlocking>("a");
+            (void)queue.PushDelayed(std::chrono::steady_clock::now(), "b");
+            // "b" becomes visible while the memory is full, so it goes to the spill
+            expect(queue.Pop<OperationPolicy::NonBlocking>().first == "a", "Pop of the head");
+            std::this_thread::sleep_for(60ms);
+            expect(queue.Pop<OperationPolicy::NonBlocking>().second == test_task::Result::Empty, "spilled delayed message after its TTL");
+        }
+
+        {
+            // nothing but a due delayed message makes the readable descriptor fire, the following Pop makes it visible
+            MessageQueue queue{ 2 };
+            queue.EnableReadinessFds();
+            (void)queue.PushDelayed(std::chrono::steady_clock::now() + 20ms, "a");
+            expect(!IsSignaled(queue.ReadableFd()), "readable descriptor before the delayed message is due");
+            pollfd pfd{ queue.ReadableFd(), POLLIN, 0 };
+            expect(::poll(&pfd, 1, 1000) == 1, "readable descriptor once the delayed message is due");
+            expect(queue.Pop<OperationPolicy::NonBlocking>().first == "a", "Pop of the due delayed message");
+            expect(!IsSignaled(queue.ReadableFd()), "readable descriptor after the delayed message is popped");
+        }
+
+        {
+            const auto path = (std::filesystem::temp_directory_path() / ("MessageQueueTests." + std::to_string(::getpid()) + ".delayed.journal")).string();
+            std::remove(path.c_str());
+            MessageQueue queue{ 2 };
+            queue.EnableJournal(StringCodec(), path);
+            bool rejected{ false };
+            try
+            {
+                (void)queue.PushDelayed(std::chrono::steady_clock::now(), "a");
+            }
+            catch (const std::logic_error&)
+            {
+                rejected = true;
+            }
+            expect(rejected, "PushDelayed accepted with the journal");
+            std::remove(path.c_str());
+        }
+        return expect.Succeeded();
+    }
+
+    // the buffer reaches the queue once full, once a Push finds it old enough or once FlushIfDue is called by NextDeadline,
+    // the destructor never waits for room and reports what it drops
+    bool CheckBatchingProducer()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "batching producer" };
+        MessageQueue queue{ 5 };
+        std::size_t dropped{ 0 };
+        {
+            test_task::BatchingProducer<MessageQueue> producer{ queue, { 2, std::chrono::microseconds::zero(), {} } };
+            (void)producer.Push<OperationPolicy::NonBlocking>("a");
+            expect(producer.Pending() == 1 && queue.GetStats().size == 0, "flush of a partial batch");
+            expect(producer.NextDeadline() == std::chrono::steady_clock::time_point::max(), "deadline without an age limit");
+            (void)producer.Push<OperationPolicy::NonBlocking>("b");
+            expect(producer.Pending() == 0 && queue.GetStats().size == 2, "flush of a full batch");
+        }
+
+        {
+            test_task::BatchingProducer<MessageQueue> producer{ queue, { 4, 10ms, [&dropped](std::size_t count) { dropped += count; } } };
+            expect(producer.NextDeadline() == std::chrono::steady_clock::time_point::max(), "deadline of an empty buffer");
+            (void)producer.Push<OperationPolicy::NonBlocking>("c");
+            std::this_thread::sleep_for(20ms);
+            expect(producer.Pending() == 1, "flush without a Push");
+            (void)producer.Push<OperationPolicy::NonBlocking>("d");
+            expect(producer.Pending() == 0 && queue.GetStats().size == 4, "flush of an aged batch");
+
+            (void)producer.Push<OperationPolicy::NonBlocking>("e");
+            const auto deadline = producer.NextDeadline();
+            expect(deadline != std::chrono::steady_clock::time_point::max(), "deadline of a partial batch");
+            expect(producer.FlushIfDue<OperationPolicy::NonBlocking>() == test_task::Result::Ok && producer.Pending() == 1, "FlushIfDue before the deadline");
+            std::this_thread::sleep_until(deadline);
+            expect(producer.FlushIfDue<OperationPolicy::NonBlocking>() == test_task::Result::Ok && producer.Pending() == 0, "FlushIfDue by the deadline");
+
+            // the queue is full and nobody drains it
+            (void)producer.Push<OperationPolicy::NonBlocking>("f");
+            (void)producer.Push<OperationPolicy::NonBlocking>("g");
+        }
+        expect(dropped == 2, "messages dropped by the destructor");
+        expect(Drain(queue) == std::vector<std::string>{ "a", "b", "c", "d", "e" }, "messages delivered by the producers");
+        return expect.Succeeded();
+    }
+
+    // a window with Full rejections grows even the smallest capacity, messages fed back from the spill count
+    // towards the high-water mark the autotuner relies on
+    bool CheckCapacityAutotuner()
+    {
+        using namespace std::chrono_literals;
+        Expectations expect{ "capacity autotuner" };
+        {
+            MessageQueue queue{ 1 };
+            queue.EnableSpill(StringCodec(), std::filesystem::temp_directory_path().string(), 64);
+            for (const auto* msg : { "a", "b", "c" })
+                (void)queue.Push<OperationPolicy::NonBlocking>(msg);
+            (void)queue.ResetHighWaterMark();
+            queue.Resize(3);
+            expect(queue.GetStats().highWaterMark == 3, "high-water mark after a refill from the spill");
+        }
+
+        {
+            MessageQueue queue{ 1 };
+            (void)queue.Push<OperationPolicy::NonBlocking>("a");
+            test_task::CapacityAutotuner<MessageQueue> autotuner{ queue, { 1, 4, 10ms, 1.5, 0.25 } };
+            expect(queue.Push<OperationPolicy::NonBlocking>("b") == test_task::Result::Full, "Push into a full queue");
+            const auto deadline = std::chrono::steady_clock::now() + 2s;
+            while (queue.GetStats().capacity == 1 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(1ms);
+            expect(queue.GetStats().capacity == 2, "capacity after a window with Full");
+        }
+        return expect.Succeeded();
+    }
+
+    // counts segment allocations of UnboundedMessageQueue
+    template<typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        explicit CountingAllocator(std::size_t& allocations) noexcept
+            : allocations{ &allocations }
+        {
+        }
+
+        template<typename U>
+        CountingAllocator(const CountingAllocator<U>& other) noexcept
+            : allocations{ other.allocations }
+        {
+        }
+
+        T* allocate(std::size_t n)
+        {
+            ++*allocations;
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template<typename U>
+        bool operator==(const CountingAllocator<U>& other) const noexcept
+        {
+            return allocations == other.allocations;
+        }
+
+        template<typename U>
+        bool operator!=(const CountingAllocator<U>& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+        std::size_t* allocations;
+    };
+
+    // FIFO order across segment boundaries, drained segments are reused from the free list without allocating,
+    // the soft cap signal follows the depth
+    bool CheckUnboundedMessageQueue()
+    {
+        Expectations expect{ "unbounded message queue" };
+        using Unbounded = test_task::UnboundedMessageQueue<std::string, 4, CountingAllocator<std::string>>;
+        using UnboundedPolicy = Unbounded::OperationPolicy;
+        std::size_t allocations{ 0 };
+        Unbounded queue{ 6, CountingAllocator<std::string>{ allocations } };
+        const auto pop = [&queue](std::size_t count) {
+            std::vector<std::string> messages;
+            for (std::size_t i = 0; i < count; ++i)
+                messages.push_back(queue.Pop<UnboundedPolicy::NonBlocking>().first);
+            return messages;
+        };
+
+        for (int i = 0; i < 10; ++i)
+            (void)queue.Push<UnboundedPolicy::NonBlocking>(std::to_string(i));
+        auto stats = queue.GetStats();
+        expect(stats.segments == 3 && stats.freeSegments == 0 && allocations == 3, "segments of a growing queue");
+        expect(queue.IsAboveSoftCap() && stats.softCapExceeded == 5, "soft cap signal of a growing queue");
+
+        expect(pop(5) == std::vector<std::string>{ "0", "1", "2", "3", "4" }, "messages popped across a segment boundary");
+        stats = queue.GetStats();
+        expect(stats.segments == 2 && stats.freeSegments == 1, "segments after the head one is drained");
+        expect(!queue.IsAboveSoftCap(), "soft cap signal below the cap");
+
+        for (int i = 10; i < 16; ++i)
+            (void)queue.Push<UnboundedPolicy::NonBlocking>(std::to_string(i));
+        stats = queue.GetStats();
+        expect(stats.segments == 3 && stats.freeSegments == 0 && allocations == 3, "segments taken from the free list");
+        expect(queue.IsAboveSoftCap(), "soft cap signal of a refilled queue");
+
+        expect(pop(11) == std::vector<std::string>{ "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15" }, "messages popped through a recycled segment");
+        stats = queue.GetStats();
+        expect(stats.size == 0 && stats.segments == 1 && stats.freeSegments == 2 && stats.highWaterMark == 11, "segments of a drained queue");
+        expect(queue.Pop<UnboundedPolicy::NonBlocking>().second == test_task::Result::Empty, "Pop of a drained queue");
+
+        queue.Close();
+        expect(queue.Push<UnboundedPolicy::NonBlocking>("closed") == test_task::Result::Closed, "Push result after Close");
+        return expect.Succeeded();
+    }
+
+    // FIFO order through a ring of a size that isn't a power of two (wrapping without a mask), Get closes the gap
+    bool CheckFixedMessageQueue()
+    {
+        Expectations expect{ "fixed message queue" };
+        using FixedQueue = test_task::FixedMessageQueue<std::uint64_t, 3>;
+        using FixedPolicy = FixedQueue::OperationPolicy;
+        FixedQueue queue;
+
+        constexpr std::uint64_t numOfMessages{ 10000 };
+        std::thread writer{ [&queue] {
+            for (std::uint64_t i = 0; i < numOfMessages; ++i)
+                (void)queue.Push<FixedPolicy::Blocking>(i);
+        } };
+        bool ordered{ true };
+        for (std::uint64_t i = 0; i < numOfMessages; ++i)
+            ordered = queue.Pop<FixedPolicy::Blocking>().first == i && ordered;
+        writer.join();
+        expect(ordered, "order of popped messages");
+
+        for (const std::uint64_t msg : { 1, 2, 3 })
+            (void)queue.Push<FixedPolicy::NonBlocking>(msg);
+        expect(queue.Push<FixedPolicy::NonBlocking>(4) == test_task::Result::Full, "Push into a full queue");
+        expect(queue.Get([](std::uint64_t msg) { return msg == 2; }).first == 2, "Get from the middle");
+        expect(queue.Pop<FixedPolicy::NonBlocking>().first == 1 && queue.Pop<FixedPolicy::NonBlocking>().first == 3, "messages left after Get");
+
+        queue.Close();
+        expect(queue.Push<FixedPolicy::NonBlocking>(5) == test_task::Result::Closed, "Push result after Close");
+        return expect.Succeeded();
+    }
+
+    // a message with a queued key replaces it in place, only a new key may find the queue full
+    bool CheckConflatingMessageQueue()
+    {
+        Expectations expect{ "conflating message queue" };
+        using Quote = std::pair<std::string, int>;
+        struct SymbolOf
+        {
+            const std::string& operator()(const Quote& quote) const noexcept
+            {
+                return quote.first;
+            }
+        };
+        using ConflatingQueue = test_task::ConflatingMessageQueue<Quote, SymbolOf>;
+        using ConflatingPolicy = ConflatingQueue::OperationPolicy;
+        ConflatingQueue queue{ 2 };
+
+        (void)queue.Push<ConflatingPolicy::NonBlocking>("a", 1);
+        (void)queue.Push<ConflatingPolicy::NonBlocking>("b", 1);
+        expect(queue.Push<ConflatingPolicy::NonBlocking>("a", 2) == test_task::Result::Ok, "Push of a queued key into a full queue");
+        expect(queue.Push<ConflatingPolicy::NonBlocking>("c", 1) == test_task::Result::Full, "Push of a new key into a full queue");
+        expect(queue.ConflatedCount() == 1, "conflated counter");
+
+        expect(queue.Pop<ConflatingPolicy::NonBlocking>().first == Quote{ "a", 2 }, "replaced message");
+        expect(queue.Pop<ConflatingPolicy::NonBlocking>().first == Quote{ "b", 1 }, "message behind the replaced one");
+        expect(queue.Pop<ConflatingPolicy::NonBlocking>().second == test_task::Result::Empty, "Pop from an empty queue");
+        return expect.Succeeded();
+    }
+
+    // every message passes the stages in order: the first one doubles it in place, the last one sums the results
+    bool CheckRingPipeline()
+    {
+        Expectations expect{ "ring pipeline" };
+        using Pipeline = test_task::RingPipeline<std::uint64_t>;
+        using PipelinePolicy = Pipeline::OperationPolicy;
+        Pipeline pipeline{ 8, 2 };
+
+        constexpr std::uint64_t numOfMessages{ 1000 };
+        std::thread writer{ [&pipeline] {
+            for (std::uint64_t i = 1; i <= numOfMessages; ++i)
+                (void)pipeline.Push<PipelinePolicy::Blocking>(i);
+        } };
+        std::thread doubler{ [&pipeline] {
+            for (std::size_t processed = 0; processed < numOfMessages;)
+                processed += pipeline.Process<PipelinePolicy::Blocking>(0, [](std::uint64_t& msg) { msg *= 2; }).first;
+        } };
+
+        std::uint64_t sum{ 0 };
+        std::uint64_t last{ 0 };
+        bool ordered{ true };
+        for (std::size_t processed = 0; processed < numOfMessages;)
+        {
+            processed += pipeline.Process<PipelinePolicy::Blocking>(1, [&](std::uint64_t& msg) {
+                ordered = msg > last && ordered;
+                last = msg;
+                sum += msg;
+            }).first;
+        }
+        writer.join();
+        doubler.join();
+
+        expect(ordered, "order of processed messages");
+        expect(sum == numOfMessages * (numOfMessages + 1), "sum of processed messages");
+        pipeline.Close();
+        expect(pipeline.Process<PipelinePolicy::NonBlocking>(0, [](std::uint64_t&) {}).second == test_task::Result::Closed, "Process result after Close");
+        return expect.Succeeded();
+    }
+
+    // every group gets every message pushed after its subscription, a lagging group is dropped by DropLagger
+    bool CheckBroadcastQueue()
+    {
+        Expectations expect{ "broadcast queue" };
+        using Broadcast = test_task::BroadcastQueue<std::uint64_t>;
+        using BroadcastPolicy = Broadcast::OperationPolicy;
+        {
+            Broadcast queue{ 4 };
+            const Broadcast::GroupId groups[]{ queue.Subscribe(), queue.Subscribe() };
+
+            constexpr std::uint64_t numOfMessages{ 1000 };
+            std::atomic<bool> ordered{ true };
+            std::vector<std::thread> readers;
+            for (const auto group : groups)
+            {
+                readers.emplace_back([&queue, &ordered, group] {
+                    for (std::uint64_t i = 0; i < numOfMessages; ++i)
+                        if (queue.Pop<BroadcastPolicy::Blocking>(group).first != i)
+                            ordered = false;
+                });
+            }
+            for (std::uint64_t i = 0; i < numOfMessages; ++i)
+                (void)queue.Push<BroadcastPolicy::Blocking>(i);
+            for (auto& reader : readers)
+                reader.join();
+            expect(ordered, "messages received by the groups");
+        }
+
+        {
+            // the handler sees the shared slot itself, every group gets the same message
+            using Names = test_task::BroadcastQueue<std::string>;
+            Names queue{ 2 };
+            const auto first = queue.Subscribe();
+            const auto second = queue.Subscribe();
+            (void)queue.Push<Names::OperationPolicy::NonBlocking>("message");
+            const std::string* seen[2]{};
+            const auto firstResult = queue.Pop<Names::OperationPolicy::NonBlocking>(first, [&seen](const std::string& msg) { seen[0] = &msg; });
+            const auto secondResult = queue.Pop<Names::OperationPolicy::NonBlocking>(second, [&seen](const std::string& msg) { seen[1] = &msg; });
+            expect(firstResult == test_task::Result::Ok && secondResult == test_task::Result::Ok, "visiting Pop results");
+            expect(seen[0] != nullptr && seen[0] == seen[1] && *seen[0] == "message", "message visited by the groups");
+            expect(queue.Pop<Names::OperationPolicy::NonBlocking>(first, [](const std::string&) {}) == test_task::Result::Empty, "visiting Pop of a drained group");
+        }
+
+        {
+            Broadcast queue{ 2, test_task::LagPolicy::DropLagger };
+            const auto fast = queue.Subscribe();
+            const auto lagging = queue.Subscribe();
+            for (const std::uint64_t msg : { 1, 2, 3 })
+            {
+                (void)queue.Push<BroadcastPolicy::NonBlocking>(msg);
+                (void)queue.Pop<BroadcastPolicy::NonBlocking>(fast);
+            }
+            expect(queue.Pop<BroadcastPolicy::NonBlocking>(lagging).second == test_task::Result::Closed, "state of the lagging group");
+        }
+        return expect.Succeeded();
+    }
+
+    // consumers read at their own offsets, may seek back within the retention and resume from it once left behind
+    bool CheckRetainedLog()
+    {
+        Expectations expect{ "retained log" };
+        using RetainedLog = test_task::RetainedLog<std::string>;
+        using LogPolicy = RetainedLog::OperationPolicy;
+        RetainedLog log{ { 3, 0 } };
+
+        for (const auto* msg : { "a", "b", "c", "d", "e" })
+            (void)log.Push(msg);
+        expect(log.BeginOffset() == 2 && log.EndOffset() == 5, "retained offsets");
+        expect(log.Pop<LogPolicy::NonBlocking>("first").first == "c", "start of an unknown consumer");
+        expect(log.Pop<LogPolicy::NonBlocking>("first").first == "d", "next message of the consumer");
+        expect(log.Pop<LogPolicy::NonBlocking>("second").first == "c", "offset of another consumer");
+
+        expect(log.Seek("first", 0) == test_task::Result::NotFound, "Seek to an evicted offset");
+        expect(log.Seek("first", 2) == test_task::Result::Ok && log.Pop<LogPolicy::NonBlocking>("first").first == "c", "Seek back");
+        (void)log.Pop<LogPolicy::NonBlocking>("first");
+        (void)log.Pop<LogPolicy::NonBlocking>("first");
+        expect(log.Pop<LogPolicy::NonBlocking>("first").second == test_task::Result::Empty, "Pop at the end of the log");
+        return expect.Succeeded();
+    }
+
+    // a recorded trace is re-executed with the same results against backends with and without Get
+    bool CheckTraceReplay()
+    {
+        using test_task::TraceOperation;
+        Expectations expect{ "trace replay" };
+        const auto event = [](std::uint32_t threadId, TraceOperation operation, test_task::Result result) {
+            return test_task::TraceEvent{ 0, 0, threadId, operation, static_cast<std::uint8_t>(result), 0 };
+        };
+        const std::vector<test_task::TraceEvent> events{
+            event(0, TraceOperation::PushNonBlocking, test_task::Result::Ok),
+            event(0, TraceOperation::PushNonBlocking, test_task::Result::Ok),
+            event(0, TraceOperation::PushNonBlocking, test_task::Result::Full),
+            event(0, TraceOperation::Get, test_task::Result::Ok),
+            event(0, TraceOperation::PopNonBlocking, test_task::Result::Ok),
+            event(0, TraceOperation::PopNonBlocking, test_task::Result::Empty),
+        };
+        const test_task::ReplayOptions options{ test_task::ReplayTiming::AsFastAsPossible };
+
+        MessageQueue queue{ 2 };
+        const auto report = test_task::ReplayTrace(events, queue, [] { return std::string{ "message" }; }, options);
+        expect(report.events == events.size() && report.mismatches == 0, "replay against MessageQueue");
+
+        test_task::FixedMessageQueue<std::string, 2> fixedQueue;
+        const auto fixedReport = test_task::ReplayTrace(events, fixedQueue, [] { return std::string{ "message" }; }, options);
+        expect(fixedReport.events == events.size() && fixedReport.mismatches == 0, "replay against FixedMessageQueue");
+        return expect.Succeeded();
+    }
+}
+
+// functional checks of MessageQueue features, every failed expectation is logged.
+// usage: MessageQueueTests
+int main()
+{
+    try
+    {
+        struct Check
+        {
+            const char* name;
+            bool (*run)();
+        };
+        const Check checks[]{
+            { "readiness fds", CheckReadinessFds },
+            { "journal recovery", CheckJournalRecovery },
+            { "journal compaction", CheckJournalCompaction },
+            { "group writer wakeups", CheckGroupWriterWakeups },
+            { "failed hand-off", CheckFailedHandOff },
+            { "failed wait", CheckFailedWait },
+            { "watermark delivery", CheckWatermarkDelivery },
+            { "spill", CheckSpill },
+            { "evictions", CheckEvictions },
+            { "expiration behind the head", CheckExpirationBehindHead },
+            { "peek and snapshot", CheckPeekAndSnapshot },
+            { "GetAll and RemoveIf", CheckGetAllAndRemoveIf },
+            { "delayed messages", CheckDelayedMessages },
+            { "batching producer", CheckBatchingProducer },
+            { "capacity autotuner", CheckCapacityAutotuner },
+            { "unbounded message queue", CheckUnboundedMessageQueue },
+            { "fixed message queue", CheckFixedMessageQueue },
+            { "conflating message queue", CheckConflatingMessageQueue },
+            { "ring pipeline", CheckRingPipeline },
+            { "broadcast queue", CheckBroadcastQueue },
+            { "retained log", CheckRetainedLog },
+            { "trace replay", CheckTraceReplay },
+        };
+
+        bool succeeded = true;
+        for (const auto& check : checks)
+        {
+            const bool passed = check.run();
+            Log(check.name, passed ? ": ok" : ": FAILED");
+            succeeded = passed && succeeded;
+        }
+
+        if (!succeeded)
+        {
+            Log("Functional checks failed");
+            return Failed;
+        }
+
+        Log("The program is finished successfully");
+    }
+    catch (const std::exception& exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return Failed;
+    }
+    catch (...)
+    {
+        std::cerr << unhandleExceptionMsg;
+        return Failed;
+    }
+
+    return Succeeded;
+}